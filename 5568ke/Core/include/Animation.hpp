@@ -2,12 +2,15 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 // Forward declarations
 class Model;
+class PoseSampler;
 
 // Bone influence for vertex skinning
 struct VertexBoneData {
@@ -69,17 +72,29 @@ struct KeyScale {
 	float timeStamp;
 };
 
-// Bone structure
+// Static skeleton data for one joint
 struct Bone {
 	std::string name;
 	int id;
 	glm::mat4 offsetMatrix;
-	glm::mat4 localTransform;
+};
+
+// Last key index used per channel of one track, -1 forces a binary search
+struct TrackCursor {
+	int position = -1;
+	int rotation = -1;
+	int scale = -1;
+};
 
+// Keyframes of one bone within one clip
+struct BoneTrack {
 	std::vector<KeyPosition> positions;
 	std::vector<KeyRotation> rotations;
 	std::vector<KeyScale> scales;
 
+	// True if the clip does not animate this bone
+	bool empty() const { return positions.empty() && rotations.empty() && scales.empty(); }
+
 	// Find appropriate position keyframe at given animation time
 	int getPositionIndex(float animationTime) const;
 
@@ -98,22 +113,93 @@ struct Bone {
 	// Interpolate between scale keyframes
 	glm::vec3 interpolateScale(float animationTime) const;
 
+	// Index of the key at or before the given time, resuming the search from a cursor and
+	// updating it (O(1) during forward playback); -1 if the channel has no keys
+	int positionKey(float animationTime, int& cursor) const;
+	int rotationKey(float animationTime, int& cursor) const;
+	int scaleKey(float animationTime, int& cursor) const;
+
+	// Variants that resume the key search from a cursor and update it
+	glm::vec3 interpolatePosition(float animationTime, int& cursor) const;
+	glm::quat interpolateRotation(float animationTime, int& cursor) const;
+	glm::vec3 interpolateScale(float animationTime, int& cursor) const;
+
 	// Calculate the local transform matrix at the given animation time
-	glm::mat4 calculateLocalTransform(float animationTime);
+	glm::mat4 calculateLocalTransform(float animationTime) const;
+	glm::mat4 calculateLocalTransform(float animationTime, TrackCursor& cursor) const;
+};
+
+// Unit quaternion in 48 bits, "smallest three" encoding: the index of the largest component
+// (2 bits) plus the other three quantized to 15 bits each over [-1/sqrt(2), 1/sqrt(2)].
+// The sign is normalized so the dropped component is positive.
+struct PackedQuat {
+	std::uint16_t bits[3] = {0, 0, 0};
+
+	static PackedQuat pack(glm::quat const& q);
+	glm::quat unpack() const;
+};
+
+// Compressed keyframes of one bone: key times are indices into the clip's shared keyTimes
+struct CompressedTrack {
+	std::vector<std::uint16_t> positionTimes;
+	std::vector<glm::vec3> positions;
+	std::vector<std::uint16_t> rotationTimes;
+	std::vector<PackedQuat> rotations;
+	std::vector<std::uint16_t> scaleTimes;
+	std::vector<glm::vec3> scales;
+
+	bool empty() const { return positions.empty() && rotations.empty() && scales.empty(); }
+
+	// Same contract as the BoneTrack cursor lookups
+	int positionKey(std::vector<float> const& keyTimes, float animationTime, int& cursor) const;
+	int rotationKey(std::vector<float> const& keyTimes, float animationTime, int& cursor) const;
+	int scaleKey(std::vector<float> const& keyTimes, float animationTime, int& cursor) const;
 };
 
-// Skeletal structure
+// Local joint-space pose, one entry per bone. Channels are kept in separate arrays so blending
+// is a linear pass over each of them.
+struct Pose {
+	std::vector<glm::vec3> translations;
+	std::vector<glm::quat> rotations;
+	std::vector<glm::vec3> scales;
+
+	size_t size() const { return rotations.size(); }
+	void resize(size_t boneCount)
+	{
+		translations.resize(boneCount, glm::vec3(0.0f));
+		rotations.resize(boneCount, glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+		scales.resize(boneCount, glm::vec3(1.0f));
+	}
+};
+
+// Normalized lerp between rotations along the shorter arc
+glm::quat nlerpShortest(glm::quat const& a, glm::quat const& b, float t);
+
+// Skeletal structure, shared by every entity using the model (poses live in AnimationInstance)
 struct Skeleton {
 	std::vector<Bone> bones;
 	std::unordered_map<std::string, int> boneNameToIndex;
-	std::vector<glm::mat4> finalBoneMatrices;
 	int boneCount = 0;
 
-	// Max bones supported by shader
-	static int const MAX_BONES = 100;
+	// Node hierarchy flattened in topological order (parents precede children). Only bones
+	// and their ancestors are kept, so a pose is one linear pass over these arrays.
+	std::vector<int> nodeParents;					 // -1 for roots
+	std::vector<int> nodeBones;						 // bone index, -1 for helper nodes
+	std::vector<glm::mat4> nodeRestTransforms; // local bind transform
+
+	// Rest transform of every bone's node as translation/rotation/scale, used where a clip has no keys
+	Pose restPose;
+
+	// Longest chain of bones below each node, 0 for leaf bones (finger tips, face bones)
+	std::vector<int> nodeHeights;
+
+	size_t nodeCount() const { return nodeParents.size(); }
+
+	// Derive restPose and nodeHeights, call once the flattened hierarchy is built
+	void finalize();
 
-	// Initialize bone matrices
-	void initBoneMatrices() { finalBoneMatrices.resize(MAX_BONES, glm::mat4(1.0f)); }
+	// Per-bone weights that select `rootBone` and every bone below it (1), everything else 0
+	std::vector<float> makeBoneMask(int rootBone) const;
 
 	// Get bone index by name, returns -1 if not found
 	int getBoneIndex(std::string const& name) const
@@ -126,42 +212,84 @@ struct Skeleton {
 	}
 };
 
-// Node in the skeleton hierarchy
-struct SkeletonNode {
+// Single animation clip, owning the keyframes of every bone it animates
+struct AnimationClip {
 	std::string name;
-	int boneIndex = -1; // -1 if this node doesn't correspond to a bone
-	glm::mat4 transformation;
-	std::vector<SkeletonNode*> children;
+	float duration = 0.0f;
+	float ticksPerSecond = 25.0f;
 
-	~SkeletonNode()
-	{
-		for (auto child : children) {
-			delete child;
-		}
-	}
+	// One track per bone, indexed by bone id (empty tracks keep the node's rest transform)
+	std::vector<BoneTrack> tracks;
+
+	// Set by compressClip(), which replaces `tracks`: sorted key times shared by every channel,
+	// and one compressed track per bone
+	std::vector<float> keyTimes;
+	std::vector<CompressedTrack> compressedTracks;
+
+	bool compressed() const { return !compressedTracks.empty(); }
+	size_t boneCount() const { return compressed() ? compressedTracks.size() : tracks.size(); }
+
+	// True if the clip has keys for the bone
+	bool animates(size_t bone) const { return compressed() ? !compressedTracks[bone].empty() : !tracks[bone].empty(); }
 };
 
-// Single animation clip
-struct Animation {
-	std::string name;
-	float duration = 0.0f;
-	float ticksPerSecond = 25.0f;
-	SkeletonNode* rootNode = nullptr;
+// Level of detail for one instance's animation
+struct AnimationLod {
+	int updateInterval = 1;		// evaluate every Nth update and interpolate the palette in between
+	int skipBoneHeight = -1;	// bones with at most this many bones below keep their rest pose (-1 = none)
+
+	bool operator==(AnimationLod const& other) const { return updateInterval == other.updateInterval && skipBoneHeight == other.skipBoneHeight; }
+};
+
+// Picks an AnimationLod from the fraction of the screen height an entity covers
+struct AnimationLodPolicy {
+	bool enabled = true;
+	float halfRateBelow = 0.25f;	 // every 2nd update
+	float quarterRateBelow = 0.1f; // every 4th update, leaf bones skipped
+	float minimalBelow = 0.03f;		 // every 8th update, the last two bones of each chain skipped
+
+	// Relative band around each threshold: a level only changes once the size is this far past
+	// the threshold, so entities sitting near one do not flip levels every tick
+	float hysteresis = 0.15f;
+
+	// Level for `screenFraction`, keeping `current` while the size stays inside its band
+	AnimationLod select(float screenFraction, AnimationLod const& current = AnimationLod()) const;
+
+private:
+	int levelFor_(float screenFraction) const; // 0 = full rate ... 3 = minimal
+	static AnimationLod lodFor_(int level);
+	static int levelOf_(AnimationLod const& lod);
+};
 
-	// Map from node name to node for quick access
-	std::unordered_map<std::string, SkeletonNode*> nodeMap;
+// How a layer combines with the pose below it
+enum class LayerBlend {
+	Override, // blend toward the layer's pose by its weight
+	Additive	// add the layer's motion relative to its first frame
+};
+
+// Clip played on top of the base clip, optionally limited to some bones
+struct AnimationLayer {
+	AnimationClip const* clip = nullptr;
+	LayerBlend blend = LayerBlend::Override;
+	float weight = 1.0f;
+	std::vector<float> boneMask; // per-bone weight multiplier, empty = every bone
 
-	~Animation() { delete rootNode; }
+	float time = 0.0f;
+	std::vector<TrackCursor> cursors;
+	Pose referencePose; // additive layers: the clip's first frame
 };
 
-// Animation player to control playback
-class AnimationPlayer {
+// Per-entity playback state: clip, time, speed and the resulting bone palette.
+// The model is only read, so any number of instances can share it.
+// On top of the base clip an instance can crossfade from the previous clip and stack layers;
+// blending runs on local poses (see Pose), only when there is something to blend.
+class AnimationInstance {
 public:
-	AnimationPlayer() = default;
-	~AnimationPlayer() = default;
+	AnimationInstance() = default;
+	~AnimationInstance() = default;
 
-	// Initialize with a model that has animations
-	void initialize(Model* model);
+	// Initialize with a model that has animations, starts in bind pose
+	void initialize(Model const* model);
 
 	// Update animation state
 	void update(float dt);
@@ -172,6 +300,17 @@ public:
 	// Set current animation by name
 	bool setAnimation(std::string const& name);
 
+	// Switch to another clip, fading out the current one (which keeps playing) over `seconds`
+	bool crossfadeTo(int index, float seconds);
+	bool crossfadeTo(std::string const& name, float seconds);
+	bool isCrossfading() const { return fadeFrom_ != nullptr; }
+
+	// Layers, applied in order on top of the base clip. Returns the layer index, -1 on failure
+	int addLayer(int clipIndex, LayerBlend blend, float weight = 1.0f, std::vector<float> boneMask = {});
+	void removeLayer(int layer);
+	void setLayerWeight(int layer, float weight);
+	std::vector<AnimationLayer> const& layers() const { return layers_; }
+
 	// Play, pause, stop controls
 	void play();
 	void pause();
@@ -179,9 +318,11 @@ public:
 
 	// Set playback speed (1.0 = normal speed)
 	void setSpeed(float speed) { playbackSpeed_ = speed; }
+	float getSpeed() const { return playbackSpeed_; }
 
 	// Set looping
 	void setLooping(bool loop) { looping_ = loop; }
+	bool isLooping() const { return looping_; }
 
 	// Get current animation name
 	std::string getCurrentAnimationName() const;
@@ -204,16 +345,71 @@ public:
 	// Is animation playing
 	bool isPlaying() const { return playing_; }
 
-	// Update bone transforms in the skeleton
-	void updateBoneTransforms(float animationTime, SkeletonNode* node, glm::mat4 const& parentTransform, Skeleton& skeleton);
+	// True once initialized with an animated model
+	bool valid() const { return model_ != nullptr; }
+
+	// Skinning matrices of the current pose, one per bone
+	std::vector<glm::mat4> const& palette() const { return palette_; }
+
+	// Level of detail, changing it restarts the palette interpolation
+	void setLod(AnimationLod const& lod);
+	AnimationLod const& getLod() const { return lod_; }
+
+	// Number of the caller's update tick about to run. A gap since the previous one means updates
+	// were skipped (e.g. the entity was hidden), so the interpolation history is stale and dropped.
+	void setTick(std::uint64_t tick);
+
+	// Bones sampled by the last update (0 if it only interpolated the palette)
+	size_t evaluatedBones() const { return evaluatedBones_; }
 
 private:
-	Model* model_ = nullptr;
-	Animation* currentAnimation_ = nullptr;
+	// Evaluate the flattened hierarchy at the given time and write the final bone matrices into palette_
+	void evaluatePose_(float animationTime);
+	void resetPalette_();
+
+	// palette_ = lodFrom_ blended toward lodTo_ by t
+	void blendLodPalette_(float t);
+
+	// Time jumped (seek, loop wrap, clip change): the next sample re-searches every track
+	void resetCursors_();
+
+	// Base clip, crossfade and layers blended into pose_, then composed into the sampler's locals
+	void blendPose_(float animationTime, PoseSampler& sampler);
+
+	Model const* model_ = nullptr;
+	AnimationClip const* currentAnimation_ = nullptr;
 	int currentAnimationIndex_ = -1;
 
 	bool playing_ = false;
 	bool looping_ = true;
 	float currentTime_ = 0.0f;
 	float playbackSpeed_ = 1.0f;
+
+	std::vector<glm::mat4> palette_;
+	std::vector<glm::mat4> nodeGlobals_; // scratch, one per skeleton node
+	std::vector<TrackCursor> cursors_;	 // one per bone, into the current clip's tracks
+
+	// Crossfade source, playing on until the fade completes
+	AnimationClip const* fadeFrom_ = nullptr;
+	float fadeFromTime_ = 0.0f;
+	float fadeDuration_ = 0.0f;
+	float fadeElapsed_ = 0.0f;
+	std::vector<TrackCursor> fadeCursors_;
+
+	std::vector<AnimationLayer> layers_;
+
+	// Blend scratch
+	Pose pose_;
+	Pose layerPose_;
+
+	// LOD: palettes of the last two evaluations split into translation, rotation and scale, shown
+	// interpolated (one interval behind). Lerping the matrices themselves would shrink rotations.
+	AnimationLod lod_;
+	std::vector<std::uint8_t> activeBones_; // per bone, 0 = skipped by the LOD; empty = all
+	Pose lodFrom_;
+	Pose lodTo_;
+	int lodTick_ = 0;
+	bool lodValid_ = false;
+	std::uint64_t lastTick_ = 0;
+	size_t evaluatedBones_ = 0;
 };
\ No newline at end of file
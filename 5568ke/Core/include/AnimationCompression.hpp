@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "Animation.hpp"
+
+// Import-time clip compression: keys that linear interpolation reproduces within the error
+// bounds are dropped, rotations are stored as 48-bit smallest-three quaternions and every
+// channel indexes one shared timestamp array. PoseSampler decodes the result directly.
+struct AnimationCompressionSettings {
+	bool enabled = true;
+	float translationError = 1e-4f; // model units
+	float rotationError = 1e-3f;		// radians
+	float scaleError = 1e-4f;
+};
+
+struct ClipCompressionReport {
+	std::string clip;
+	bool compressed = false; // false if the clip was left as is
+	size_t rawKeys = 0;
+	size_t keptKeys = 0;
+	size_t rawBytes = 0;
+	size_t compressedBytes = 0;
+	float maxJointError = 0.0f; // largest model-space joint position error at the original key times
+
+	float ratio() const { return compressedBytes > 0 ? static_cast<float>(rawBytes) / static_cast<float>(compressedBytes) : 1.0f; }
+};
+
+// Compress `clip` in place, replacing its raw tracks. The skeleton is only used to measure the
+// joint error, so the clip must belong to it.
+ClipCompressionReport compressClip(AnimationClip& clip, Skeleton const& skeleton, AnimationCompressionSettings const& settings = {});
@@ -5,6 +5,7 @@
 #include <array>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "ImGuiManager.hpp"
 #include "ModelRegistry.hpp"
@@ -34,6 +35,7 @@ private:
 	void draw_(float interpolation); // Render the scene
 	void drawScene_();							 // Draw the 3D scene
 	void processInput_(float dt);
+	void updateAnimations_(float dt);
 
 	// Cleanup
 	void cleanup_();
@@ -54,6 +56,24 @@ private:
 	std::array<bool, 1024> keys_ = {false};
 	std::array<bool, 1024> prevKeys_ = {false}; // For detecting key press events
 
+	// Entities animated this tick, and how many of them one job updates
+	std::vector<Entity*> animatedEntities_;
+	static constexpr size_t ANIMATION_JOB_GRAIN = 4;
+
+	// Time per frame spent uploading models that finished importing in the background
+	static constexpr double MODEL_UPLOAD_BUDGET_MS = 4.0;
+
+	// Animation LOD by projected size, and what the last tick evaluated
+	AnimationLodPolicy animationLod_;
+	std::uint64_t animationTick_ = 0; // lets instances notice ticks they were skipped in
+	struct AnimationStats {
+		int playing = 0;
+		int posesEvaluated = 0;
+		size_t bonesEvaluated = 0;
+		size_t bonesSaved = 0;
+	};
+	AnimationStats animationStats_;
+
 	// Track which scene is currently loaded
 	std::string currentScene_ = "default";
 
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+
+// Command-line microbenchmarks, run with `5568ke4 --bench <name>` (no window or GL context needed)
+namespace Benchmark {
+
+// Run the named benchmark ("all" runs every one), returns the process exit code
+int run(std::string const& name);
+
+// Frustum culling: naive per-entity glm path vs the SoA FrustumCuller kernel
+void culling();
+
+// Skeleton pose evaluation: recursive SkeletonNode walk vs the flattened hierarchy
+void skeleton();
+
+// Keyframe lookup during forward playback: binary search per sample vs TrackCursor
+void keyframes();
+
+// Track sampling: per-bone BoneTrack::calculateLocalTransform vs the batched PoseSampler
+void sampling();
+
+// Clip compression: size, kept keys and joint error of compressClip, and sampling cost raw vs compressed
+void compression();
+
+// Animation update phase: every instance updated on 1..N job system threads
+void animation();
+
+} // namespace Benchmark
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "include_5568ke.hpp"
+
+#include <glm/glm.hpp>
+#include <array>
+#include <cstddef>
+
+// Streams skinning palettes into a texture buffer that shaders read as a samplerBuffer.
+// The storage is split into FRAME_SEGMENTS regions used round-robin, one per frame, and
+// each palette is written with a single unsynchronized mapped range.
+class BonePaletteBuffer {
+public:
+	// Texture unit the palette is bound to (0 and 1 are used by materials)
+	static constexpr unsigned TEXTURE_SLOT = 2;
+
+	BonePaletteBuffer() = default;
+	~BonePaletteBuffer();
+
+	BonePaletteBuffer(BonePaletteBuffer const&) = delete;
+	BonePaletteBuffer& operator=(BonePaletteBuffer const&) = delete;
+
+	// Create GL resources, capacity is per frame and grows on demand
+	void init(size_t matricesPerFrame = 1024);
+
+	// Move to the next ring segment, waiting for the GPU if it still reads it
+	void beginFrame();
+
+	// Fence the segment written this frame
+	void endFrame();
+
+	// Upload one palette, returns the index of its first matrix within this frame's segment (-1 on
+	// failure, or when the frame's palettes would not fit in GL_MAX_TEXTURE_BUFFER_SIZE). Add
+	// segmentBase() when drawing: the segment may move if the buffer grows later on.
+	int upload(glm::mat4 const* matrices, size_t count);
+
+	// Index of the first matrix of this frame's segment, final once all palettes are uploaded
+	int segmentBase() const { return static_cast<int>(static_cast<size_t>(segment_) * segmentCapacity_); }
+
+	// Bind the palette texture to TEXTURE_SLOT
+	void bind() const;
+
+	// Matrices written during the current frame
+	size_t matricesThisFrame() const { return cursor_; }
+
+	void cleanup();
+
+private:
+	static constexpr int FRAME_SEGMENTS = 3;
+
+	// Reallocate with a larger segment size, keeping what was written this frame
+	void grow_(size_t matricesPerFrame);
+
+	GLuint buffer_ = 0;
+	GLuint texture_ = 0;
+	size_t segmentCapacity_ = 0;		// matrices per segment
+	size_t maxSegmentCapacity_ = 0; // largest segment the texture buffer limit allows
+	bool overflowLogged_ = false;
+	int segment_ = 0;
+	size_t cursor_ = 0; // matrices used in the current segment
+	std::array<GLsync, FRAME_SEGMENTS> fences_{};
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <array>
+
+#include "BoundingBox.hpp"
+
+// View frustum as six inward-facing planes (xyz = normal, w = distance)
+struct Frustum {
+	enum Plane { Left, Right, Bottom, Top, Near, Far, PlaneCount };
+
+	std::array<glm::vec4, PlaneCount> planes;
+
+	// Extract planes from a view-projection matrix (Gribb/Hartmann)
+	static Frustum fromMatrix(glm::mat4 const& viewProj);
+
+	// True if the box is at least partially inside
+	bool intersects(BoundingBox const& box) const;
+};
+
+// Axis-aligned bounds of a box after an affine transform
+BoundingBox transformBoundingBox(BoundingBox const& box, glm::mat4 const& transform);
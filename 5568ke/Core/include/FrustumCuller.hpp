@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "BoundingBox.hpp"
+#include "Frustum.hpp"
+
+// Batch frustum test over world-space boxes stored as SoA center/extent arrays.
+// Boxes are tested 8 at a time with AVX2, 4 at a time with SSE2, or one by one otherwise.
+class FrustumCuller {
+public:
+	void clear();
+	void reserve(size_t count);
+
+	// Add a world-space box, returns its index
+	size_t add(BoundingBox const& worldBox);
+
+	size_t size() const { return centerX_.size(); }
+
+	// Write 1 (visible) or 0 (culled) per box, returns the number of visible boxes
+	size_t cull(Frustum const& frustum, std::vector<std::uint8_t>& visible) const;
+
+	// Scalar kernel over [begin, end), used for the tail and as the portable fallback
+	size_t cullScalar(Frustum const& frustum, std::uint8_t* visible, size_t begin, size_t end) const;
+
+	// Name of the kernel selected at compile time
+	static char const* kernelName();
+
+private:
+	std::vector<float> centerX_, centerY_, centerZ_;
+	std::vector<float> extentX_, extentY_, extentZ_;
+};
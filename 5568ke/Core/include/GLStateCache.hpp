@@ -0,0 +1,67 @@
+#pragma once
+
+#include "include_5568ke.hpp"
+
+#include <array>
+
+// Shadows the GL state the engine touches and drops calls that would not change it.
+// All engine code binds programs, VAOs and textures through here; code that changes
+// these bindings behind its back must call invalidate().
+class GLStateCache {
+public:
+	static GLStateCache& getInstance()
+	{
+		static GLStateCache instance;
+		return instance;
+	}
+
+	static constexpr unsigned MAX_TEXTURE_UNITS = 16;
+
+	struct Counters {
+		int issued = 0;
+		int elided = 0;
+	};
+
+	void useProgram(GLuint program);
+	void bindVertexArray(GLuint vao);
+
+	// Bind a texture to a unit, switching the active unit only if needed
+	void bindTexture(unsigned unit, GLenum target, GLuint texture);
+
+	// Forget a deleted texture so a recycled name is not mistaken for a bound one
+	void forgetTexture(GLuint texture);
+
+	void enable(GLenum cap);
+	void disable(GLenum cap);
+	void cullFace(GLenum mode);
+
+	// Mark every shadowed value as unknown
+	void invalidate();
+
+	// Per-frame call counters, reset at the start of each frame
+	void resetFrameCounters() { counters_ = Counters(); }
+	Counters const& frameCounters() const { return counters_; }
+
+private:
+	GLStateCache() { invalidate(); }
+
+	void activeTexture_(unsigned unit);
+	void setCapability_(GLenum cap, bool enabled);
+
+	// Shadowed texture targets, anything else is passed through
+	enum TextureTarget { TARGET_2D, TARGET_BUFFER, TARGET_COUNT };
+
+	// Shadowed capabilities
+	enum Capability { CAP_DEPTH_TEST, CAP_CULL_FACE, CAP_BLEND, CAP_COUNT };
+
+	static constexpr GLuint UNKNOWN = ~0u;
+
+	GLuint program_ = UNKNOWN;
+	GLuint vao_ = UNKNOWN;
+	unsigned activeUnit_ = UNKNOWN;
+	std::array<std::array<GLuint, MAX_TEXTURE_UNITS>, TARGET_COUNT> textures_{};
+	std::array<int, CAP_COUNT> capabilities_{}; // -1 unknown, 0 disabled, 1 enabled
+	GLenum cullFace_ = GL_NONE;
+
+	Counters counters_;
+};
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed pool of worker threads with one work-stealing deque each. The owner of a deque pushes
+// and pops at the back (newest first, cache-warm); idle threads steal from the front of other
+// deques. Threads that are not workers (the main thread, loader threads) share one extra deque
+// and, while they wait, help run only the jobs of their own parallelFor, so one caller's long
+// jobs never add to another caller's latency. A pool of N workers uses N + 1 threads.
+class JobSystem {
+public:
+	static JobSystem& getInstance()
+	{
+		static JobSystem instance;
+		return instance;
+	}
+
+	// Restart the pool with `workers` threads (the default is one less than the hardware threads)
+	void setWorkerCount(size_t workers);
+	size_t workerCount() const { return workers_.size(); }
+
+	// Run fn(begin, end) over [0, count) in chunks of at most `grain` items and return once all
+	// chunks ran. Chunks run concurrently, so fn must only touch state owned by its range.
+	void parallelFor(size_t count, size_t grain, std::function<void(size_t, size_t)> const& fn);
+
+private:
+	JobSystem();
+	~JobSystem();
+
+	struct Job {
+		std::function<void()> run;
+		std::atomic<size_t>* pending = nullptr; // decremented once the job ran
+	};
+
+	class WorkQueue {
+	public:
+		void push(Job job);
+		bool pop(Job& job);		// owner, back
+		bool steal(Job& job); // thieves, front
+
+		// Newest job of the batch counted by `pending`, for callers sharing the deque
+		bool popBatch(Job& job, std::atomic<size_t> const* pending);
+
+	private:
+		std::mutex mutex_;
+		std::deque<Job> jobs_;
+	};
+
+	void start_(size_t workers);
+	void stop_();
+	void workerLoop_(size_t index);
+
+	// Own deque first, then the others starting after `self`
+	bool findJob_(size_t self, Job& job);
+
+	// Job to run while waiting on `pending`: any job for workers, only that batch's jobs otherwise
+	bool findHelpJob_(size_t self, std::atomic<size_t> const* pending, Job& job);
+	void execute_(Job& job);
+
+	// Deque of the calling thread: its own for workers, the shared one otherwise
+	size_t queueIndex_() const;
+
+	std::vector<std::thread> workers_;
+	std::vector<std::unique_ptr<WorkQueue>> queues_; // one per worker, then the shared one
+
+	std::mutex sleepMutex_;
+	std::condition_variable wake_;
+	std::atomic<size_t> queuedJobs_{0};
+	std::atomic<bool> running_{false};
+};
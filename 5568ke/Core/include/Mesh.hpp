@@ -15,11 +15,42 @@ public:
 	bool hasAnimation = false;
 
 	void setup();
-	void draw(Shader& shader) const;
+	void draw(Shader& shader, MaterialTable const& materials) const;
+
+	// Bind the VAO and index buffer, then draw primitives one by one
+	void bind() const;
+	void drawPrimitive(Primitive const& prim) const;
+
+	// Per-instance model matrix occupies four attribute slots starting here, its normal matrix three more
+	static constexpr unsigned INSTANCE_MATRIX_ATTRIB = 5;
+	static constexpr unsigned INSTANCE_NORMAL_MATRIX_ATTRIB = 9;
+
+	// Second VAO over this mesh's buffers with the per-instance slots enabled (divisor 1), so the
+	// plain VAO never reads instance attributes. Created on first use.
+	unsigned instancedVao() const;
+
+	// Source the instance attributes from the InstanceData in `buffer` at `byteOffset` (instancedVao must be bound)
+	void bindInstanceAttributes(unsigned buffer, size_t byteOffset) const;
+	void drawPrimitiveInstanced(Primitive const& prim, int instanceCount) const;
+
+	// GL vertex array name
+	unsigned vao() const { return vao_; }
+
+	// Second VAO sharing this mesh's index buffer but reading interleaved position, normal and
+	// uv (SkinnedVertex) from `buffer`, used to draw pre-skinned output. Created on first use.
+	unsigned skinnedVao(unsigned buffer) const;
+
+	// Draw with every vertex index offset by baseVertex (to address one range of a shared buffer)
+	void drawPrimitiveBaseVertex(Primitive const& prim, int baseVertex) const;
 
 	// Cleanup resources
 	void cleanup();
 
 private:
+	// Vertex attributes 0-4 of the bound VAO from vbo_ (must be bound to GL_ARRAY_BUFFER)
+	void setupVertexAttributes_() const;
+
 	unsigned vao_ = 0, vbo_ = 0, ebo_ = 0;
+	mutable unsigned instancedVao_ = 0;
+	mutable unsigned skinnedVao_ = 0, skinnedSource_ = 0;
 };
\ No newline at end of file
@@ -9,6 +9,7 @@
 #include "BoundingBox.hpp"
 #include "Mesh.hpp"
 #include "Shader.hpp"
+#include "Texture.hpp"
 
 
 class Model {
@@ -21,6 +22,12 @@ public:
 	std::vector<BoundingBox> boundingBoxes;
 	BoundingBox globalBoundingBox;
 
+	// Materials referenced by index from each Primitive
+	MaterialTable materials;
+
+	// References this model holds in the TextureCache, released by cleanup()
+	std::vector<Texture*> textures;
+
 	// Metadata
 	std::string name;
 	std::string filePath;
@@ -30,18 +37,26 @@ public:
 	glm::vec3 defaultRotation = glm::vec3(0.0f);
 	glm::vec3 defaultTranslation = glm::vec3(0.0f);
 
-	// Animation data
+	// Animation data, shared by all entities (playback state lives in Entity::animation)
 	Skeleton skeleton;
-	std::vector<Animation> animations;
-	AnimationPlayer animationPlayer;
+	std::vector<AnimationClip> animations;
 	bool hasAnimations = false;
 
+	// Bind-pose bounds of the vertices each bone influences (indexed like the palette, empty boxes have
+	// min > max) and of the vertices no bone moves; filled by calculateBoneBoundingBoxes
+	std::vector<BoundingBox> boneBoundingBoxes;
+	BoundingBox rigidBoundingBox{glm::vec3(0.0f), glm::vec3(-1.0f)};
+
+	// Fill the boxes above from the mesh vertices, once their bone weights are applied
+	void calculateBoneBoundingBoxes();
+
+	// Model-space bounds of the meshes skinned with `palette`. Every skinned vertex is a convex blend of
+	// its bones' transforms, so it stays inside the union of each bone's box moved by that bone.
+	BoundingBox poseBoundingBox(std::vector<glm::mat4> const& palette) const;
+
 	// Methods for drawing
 	void draw(Shader& shader, glm::mat4 const& modelMatrix) const;
 
-	// Update animation (if any)
-	void updateAnimation(float dt);
-
 	// Calculate a centered and scaled matrix based on model's bounding box
 	glm::mat4 calculateCenteredTransform(float scale = 1.0f) const;
 
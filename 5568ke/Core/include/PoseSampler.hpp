@@ -0,0 +1,83 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Animation.hpp"
+
+// Batched keyframe sampler: samples every bone track of a clip at once. Bracketing keys are
+// gathered into SoA streams, then translation/scale lerp, rotation nlerp (with sign correction)
+// and the T*R*S composition run 8 bones at a time with AVX2, 4 with SSE2, or one by one otherwise.
+class PoseSampler {
+public:
+	// Sample all tracks of `clip` at `time` into locals(), one affine matrix per bone (bottom row 0,0,0,1).
+	// Bones without keys in the clip are left as identity, callers use their rest transform instead.
+	// Channels an animated bone has no keys for take their `rest` values when given, the identity otherwise.
+	// Compressed clips are decoded here, one bracketing key pair per channel.
+	// A non-null `activeBones` (one flag per bone) skips the key search for bones flagged 0.
+	void sample(AnimationClip const& clip, float time, std::vector<TrackCursor>& cursors, std::vector<std::uint8_t> const* activeBones = nullptr,
+							Pose const* rest = nullptr);
+
+	std::vector<glm::mat4> const& locals() const { return locals_; }
+
+	// Sample into a local pose for blending instead; bones without keys (or inactive) take their `rest` values,
+	// and so do the channels a bone has no keys for (e.g. translation/scale of a rotation-only bone)
+	void samplePose(AnimationClip const& clip, float time, std::vector<TrackCursor>& cursors, Pose const& rest, Pose& out,
+									std::vector<std::uint8_t> const* activeBones = nullptr);
+
+	// Compose a (blended) pose into locals()
+	void compose(Pose const& pose);
+
+	// Name of the kernel selected at compile time
+	static char const* kernelName();
+
+private:
+	// One float per bone in each stream: bracketing keys (0/1) and the blend factor of each channel
+	enum Stream {
+		TX0,
+		TY0,
+		TZ0,
+		TX1,
+		TY1,
+		TZ1,
+		TF,
+		SX0,
+		SY0,
+		SZ0,
+		SX1,
+		SY1,
+		SZ1,
+		SF,
+		QX0,
+		QY0,
+		QZ0,
+		QW0,
+		QX1,
+		QY1,
+		QZ1,
+		QW1,
+		QF,
+		STREAM_COUNT
+	};
+
+	float* stream_(Stream s) { return streams_.data() + static_cast<size_t>(s) * capacity_; }
+
+	// Scalar: find keys through the cursors (raw or compressed tracks) and fill the streams.
+	// Channels without keys take their `rest` values when given, the identity otherwise.
+	void gather_(AnimationClip const& clip, float time, std::vector<TrackCursor>& cursors, std::vector<std::uint8_t> const* activeBones,
+							 Pose const* rest = nullptr);
+
+	// Blend and compose bones [begin, end) one at a time, used for the tail and as the portable fallback
+	void composeScalar_(size_t begin, size_t end);
+
+	// Blended channels of one bone from the streams
+	glm::vec3 translation_(size_t i);
+	glm::quat rotation_(size_t i);
+	glm::vec3 scale_(size_t i);
+
+	size_t capacity_ = 0;
+	std::vector<float> streams_;
+	std::vector<glm::mat4> locals_;
+};
@@ -1,9 +1,19 @@
 #pragma once
 
+#include <cstdint>
+
 #include "Material.hpp"
 
 struct Primitive {
+	static constexpr std::uint16_t NO_MATERIAL = 0xffff;
+
 	unsigned int indexOffset;
 	unsigned int indexCount;
-	Material* material;
+	std::uint16_t material = NO_MATERIAL; // index into the owning model's material table
 };
+
+// Material `prim` is drawn with, nullptr if it has none
+inline Material* materialOf(Primitive const& prim, MaterialTable const& materials)
+{
+	return prim.material < materials.size() ? materials[prim.material].get() : nullptr;
+}
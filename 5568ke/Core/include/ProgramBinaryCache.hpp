@@ -0,0 +1,63 @@
+#pragma once
+
+#include "include_5568ke.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// On-disk cache of linked programs (glGetProgramBinary / glProgramBinary). Entries are keyed by
+// a hash of the final stage sources (defines included), the transform feedback varyings and the
+// driver's vendor, renderer and version strings, so a driver update or an edited shader simply
+// misses and is compiled from source again. Needs GL 4.1 or ARB_get_program_binary at runtime;
+// without it every lookup misses and nothing is written.
+class ProgramBinaryCache {
+public:
+	static ProgramBinaryCache& getInstance()
+	{
+		static ProgramBinaryCache instance;
+		return instance;
+	}
+
+	struct Stats {
+		int hits = 0;
+		int misses = 0;
+		double loadMs = 0.0;		// spent restoring binaries
+		double compileMs = 0.0; // spent compiling and linking on misses
+		double savedMs = 0.0;		// compile time recorded with each hit, minus its load time
+	};
+
+	// Directory holding the cache files, created on first store
+	void setDirectory(std::string const& directory) { directory_ = directory; }
+	std::string const& directory() const { return directory_; }
+
+	void setEnabled(bool enabled) { enabled_ = enabled; }
+	bool enabled() const { return enabled_; }
+
+	// Cache key for a program built from these sources and varyings on the current driver
+	std::uint64_t key(std::vector<std::string> const& sources, std::vector<std::string> const& varyings);
+
+	// Restore the program for `key` into `program`, true if it linked
+	bool load(std::uint64_t key, GLuint program);
+
+	// Mark `program` retrievable, call before linking a program that will be stored
+	void prepare(GLuint program);
+
+	// Write the linked `program`, remembering how long it took to build from source
+	void store(std::uint64_t key, GLuint program, double compileMs);
+
+	Stats const& stats() const { return stats_; }
+
+private:
+	ProgramBinaryCache() = default;
+
+	// GL entry points and at least one binary format are present (checked once, needs a context)
+	bool supported_();
+	std::string path_(std::uint64_t key) const;
+
+	std::string directory_ = "shader_cache";
+	bool enabled_ = true;
+	int supportState_ = -1; // -1 = not checked yet
+	std::string driver_;
+	Stats stats_;
+};
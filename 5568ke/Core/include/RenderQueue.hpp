@@ -0,0 +1,79 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+#include "Vertex.hpp"
+
+class Material;
+class Mesh;
+class Shader;
+struct Primitive;
+
+// Inverse transpose of the upper 3x3 of `model`, for transforming normals. Rotation with
+// uniform scale takes a shortcut; anything else (non-uniform scale, shear) is inverted.
+glm::mat3 computeNormalMatrix(glm::mat4 const& model);
+
+// Per-entity data shared by all draw items of one entity
+struct RenderObject {
+	glm::mat4 transform{1.0f};
+	glm::mat3 normalMatrix{1.0f};
+	int boneBase = -1; // first palette matrix within this frame's BonePaletteBuffer segment, -1 if not skinned
+};
+
+// One primitive to draw, ordered by its 64-bit sort key
+struct DrawItem {
+	std::uint64_t key = 0;
+	Shader* shader = nullptr;
+	Material const* material = nullptr;
+	Mesh const* mesh = nullptr;
+	Primitive const* primitive = nullptr;
+	unsigned vao = 0; // mesh.vao(), its instancedVao for instanced items or skinnedVao for pre-skinned ones
+	std::uint32_t object = 0; // index into the queue's render objects
+
+	// Instanced items draw instanceCount copies whose model matrices start at firstInstance
+	std::uint32_t firstInstance = 0;
+	std::uint32_t instanceCount = 0; // 0 = regular draw using `object`
+
+	// Pre-skinned items draw the SkinningStage output range starting at this vertex
+	int baseVertex = -1; // -1 = the mesh's own vertices
+};
+
+// Collects draw items each frame and radix-sorts them so that items sharing
+// program, material, textures and VAO end up next to each other.
+//
+// Key layout (most significant first):
+//   63..56 program | 55..40 material | 39..28 texture set | 27..16 VAO | 15..0 depth
+class RenderQueue {
+public:
+	// Build a sort key; ids are folded into their fields, depth is normalized to [0, 1]
+	static std::uint64_t makeKey(std::uint32_t program, std::uint32_t material, std::uint32_t textureSet, std::uint32_t vao, float depth);
+
+	void clear();
+
+	// Register per-entity data, returns the index to store in DrawItem::object
+	std::uint32_t addObject(glm::mat4 const& transform, int boneBase);
+
+	// Append per-instance model matrices (and their normal matrices), returns the index of the first one
+	std::uint32_t addInstances(glm::mat4 const* transforms, size_t count);
+
+	void push(DrawItem const& item) { items_.push_back(item); }
+
+	// Radix sort the items by key (stable, LSD, 8 bits per pass)
+	void sort();
+
+	// Items in sorted order (valid after sort())
+	std::vector<DrawItem> const& items() const { return items_; }
+	RenderObject const& object(std::uint32_t index) const { return objects_[index]; }
+	std::vector<InstanceData> const& instances() const { return instances_; }
+
+	bool empty() const { return items_.empty(); }
+	size_t size() const { return items_.size(); }
+
+private:
+	std::vector<DrawItem> items_;
+	std::vector<DrawItem> scratch_;
+	std::vector<RenderObject> objects_;
+	std::vector<InstanceData> instances_;
+};
@@ -1,12 +1,16 @@
 #pragma once
 
 #include <glm/vec3.hpp>
-#include <memory>
 #include <unordered_map>
 #include <vector>
 
+#include "BonePaletteBuffer.hpp"
+#include "FrustumCuller.hpp"
+#include "RenderQueue.hpp"
 #include "Scene.hpp"
 #include "Shader.hpp"
+#include "ShaderLibrary.hpp"
+#include "SkinningStage.hpp"
 
 class Renderer {
 public:
@@ -14,29 +18,104 @@ public:
 	~Renderer();
 
 	void setupDefaultRenderer();
-	void beginFrame(int w, int h, glm::vec3 const& clear);
+	void beginFrame(int w, int h, glm::vec3 const& clear, Scene const& scene);
 	void drawScene(Scene const& scene);
 	void endFrame();
 
+	// Release GL resources, must run while the context is still current
+	void cleanup();
+
+	// Skin animated meshes once per frame with transform feedback and draw the result as static
+	// geometry, instead of blending bones in the vertex shader of every draw
+	void setPreSkinning(bool enabled) { preSkinning_ = enabled; }
+	bool preSkinning() const { return preSkinning_; }
+
+	// Per-frame stats
+	struct FrameStats {
+		int drawCalls = 0;
+		int visibleEntities = 0;
+
+		// Frustum culling
+		int culledEntities = 0;
+		int culledMeshes = 0;
+
+		// State changes issued while submitting the sorted render queue
+		int drawItems = 0;
+		int programBinds = 0;
+		int materialBinds = 0;
+		int vaoBinds = 0;
+		int objectUniformUpdates = 0;
+
+		// Repeated static meshes drawn with glDrawElementsInstanced
+		int instancedBatches = 0;
+		int instancesDrawn = 0;
+
+		// Transform feedback pre-skinning
+		int preSkinnedMeshes = 0;
+		size_t preSkinnedVertices = 0;
+
+		// Uniform traffic: FrameData is written once instead of per entity
+		size_t frameDataBytes = 0;
+		size_t uniformBytesSaved = 0;
+	};
+
+	// Stats of the last completed frame (or the one in progress)
+	FrameStats const& frameStats() const { return currentFrameStats_; }
+
+	// Shader variants compiled so far
+	size_t shaderVariantCount() const { return shaderLibrary_.variantCount(); }
+
 private:
-	// Different shaders for different rendering techniques
-	std::unordered_map<std::string, std::unique_ptr<Shader>> shaders_;
-	Shader* mainShader_ = nullptr;
-	Shader* animatedShader_ = nullptr; // For skinned mesh animation
-	Shader* skyboxShader_ = nullptr;
+	// Blinn-Phong variants per geometry and material feature bits (see ShaderFeature)
+	ShaderLibrary shaderLibrary_;
+
+	// Streamed skinning palettes for all animated entities
+	BonePaletteBuffer bonePalette_;
+
+	// Optional transform feedback pass writing skinned vertices once per frame
+	SkinningStage skinning_;
+	bool preSkinning_ = false;
+
+	// Draw items of the current frame, sorted by state
+	RenderQueue queue_;
+
+	// Entity-level culling: world bounds of candidate entities and the kernel output
+	FrustumCuller culler_;
+	std::vector<Entity const*> cullCandidates_;
+	std::vector<std::uint8_t> cullVisibility_;
+
+	// FrameData uniform block, bound at FRAME_DATA_BINDING
+	GLuint frameDataUbo_ = 0;
+
+	// Visible placements of one static mesh this frame
+	struct InstanceGroup {
+		Mesh const* mesh = nullptr;
+		MaterialTable const* materials = nullptr;
+		std::vector<glm::mat4> transforms;
+		std::vector<float> depths;
+	};
+	std::vector<InstanceGroup> instanceGroups_;
+	std::unordered_map<Mesh const*, size_t> instanceGroupIndex_;
+	size_t activeInstanceGroups_ = 0;
+
+	// Per-instance model and normal matrices of all instanced batches, re-streamed every frame
+	GLuint instanceVbo_ = 0;
+	size_t instanceVboCapacity_ = 0;
 
 	// Helper methods for different rendering passes
 	void drawModels_(Scene const& scene);
-	void setupLighting_(Scene const& scene, Shader* shader);
+	void buildQueue_(Scene const& scene);
+	void submitQueue_();
+	void pushMeshItems_(std::uint32_t geometryFeatures, Mesh const& mesh, MaterialTable const& materials, std::uint32_t object, std::uint32_t firstInstance,
+											std::uint32_t instanceCount, float depth, int baseVertex = -1);
+	InstanceGroup& instanceGroup_(Mesh const* mesh, MaterialTable const* materials);
+	void uploadInstances_();
+	void updateFrameData_(Scene const& scene);
 
 	// Renderer state
 	int viewportWidth_ = 0;
 	int viewportHeight_ = 0;
 
 	// Current frame stats
-	struct FrameStats {
-		int drawCalls = 0;
-		int visibleEntities = 0;
-	};
 	FrameStats currentFrameStats_;
 };
\ No newline at end of file
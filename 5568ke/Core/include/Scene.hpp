@@ -25,6 +25,9 @@ struct Entity {
 	Model* model;
 	glm::mat4 transform;
 
+	// Playback state and pose of this entity, only valid for animated models
+	AnimationInstance animation;
+
 	// Additional entity properties
 	std::string name;
 	bool visible{true};
@@ -39,6 +42,8 @@ public:
 	glm::mat4 view() const { return view_; }
 	glm::mat4 proj() const { return proj_; }
 	glm::vec3 position() const { return pos_; }
+	float nearPlane() const { return zNear_; }
+	float farPlane() const { return zFar_; }
 
 	// Set position and target
 	void lookAt(glm::vec3 const& position, glm::vec3 const& target);
@@ -49,6 +54,8 @@ public:
 	float yaw_{-90.0f}; // look -Z in OpenGL
 	float pitch_{0.0f};
 	glm::vec3 front_{0.0f, 0.0f, -1.0f};
+	float zNear_{0.1f};
+	float zFar_{100.0f};
 	// ---- cached matrices ----
 	glm::mat4 view_{1.0f};
 	glm::mat4 proj_{1.0f};
@@ -67,6 +74,8 @@ public:
 	// Helper methods for scene management
 	void addEntity(Model* model, glm::mat4 const& transform, std::string const& name = "");
 	void removeEntity(std::string const& name);
+	// Swap the model an entity draws (e.g. a placeholder for the loaded one), restarting its animation
+	bool replaceModel(std::string const& name, Model* model);
 	Entity* findEntity(std::string const& name);
 
 	void addLight(glm::vec3 const& position, glm::vec3 const& color = glm::vec3(1.0f), float intensity = 1.0f);
@@ -3,22 +3,75 @@
 #include "include_5568ke.hpp"
 
 #include <glm/glm.hpp>
+#include <cstdint>
 #include <string>
+#include <vector>
+
+// Typed handle to a uniform name. Handles are global (the same handle works with every Shader)
+// and stay valid across hot reloads; each Shader resolves them to its own cached location.
+struct UniformHandle {
+	unsigned id = ~0u;
+
+	bool valid() const { return id != ~0u; }
+};
 
 class Shader {
 public:
-	void resetShader(std::string const& vertPath, std::string const& fragPath);
+	// `defines` are injected into both stages right after the #version line (see ShaderLibrary)
+	void resetShader(std::string const& vertPath, std::string const& fragPath, std::vector<std::string> const& defines = {});
+
+	// Vertex-only program whose outputs are captured with transform feedback, interleaved in
+	// the order given; draw it with GL_RASTERIZER_DISCARD enabled
+	void resetFeedbackShader(std::string const& vertPath, std::vector<std::string> const& varyings);
 	void reload();
 	void bind() const;
 	void unbind() const;
 
+	// GL program name
+	unsigned id() const { return program_; }
+
+	// Register (or look up) a uniform name; cache the result in hot paths
+	static UniformHandle uniform(char const* name);
+
+	// Cached location of a uniform for this program, -1 if it is not active
+	int location(UniformHandle handle) const;
+	int location(char const* name) const;
+
+	void setMat4(UniformHandle handle, glm::mat4 const& mat) const;
+	void setMat3(UniformHandle handle, glm::mat3 const& mat) const;
+	void setVec3(UniformHandle handle, glm::vec3 const& vec) const;
+	void setFloat(UniformHandle handle, float value) const;
+	void setInt(UniformHandle handle, int value) const;
+	void setBool(UniformHandle handle, bool value) const;
+
 	void setMat4(char const* name, glm::mat4 const& mat) const;
+	void setMat3(char const* name, glm::mat3 const& mat) const;
 	void setVec3(char const* name, glm::vec3 const& vec) const;
 	void setFloat(char const* name, float value) const;
 	void setInt(char const* name, int value) const;
 	void setBool(char const* name, bool value) const;
 
 private:
+	// Compile both stages and link them into program_
+	void linkFromSource_(std::string const& vsSource, std::string const& fsSource);
+
+	// Introspect active uniforms after linking and rebuild the location table
+	void buildUniformTable_();
+
+	struct UniformSlot {
+		std::uint32_t hash = 0;
+		int location = -1;
+		std::string name; // empty marks a free slot
+	};
+
 	unsigned program_ = 0;
 	std::string vsPath_, fsPath_;
-};
\ No newline at end of file
+	std::vector<std::string> defines_;
+	std::vector<std::string> feedbackVaryings_;
+
+	// Open-addressed name -> location table, rebuilt on every reload()
+	std::vector<UniformSlot> uniformTable_;
+
+	// Handle id -> location, resolved lazily from uniformTable_ (-2 = not resolved yet)
+	mutable std::vector<int> handleLocations_;
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Shader.hpp"
+
+// Feature bits selecting a shader variant; each set bit becomes a #define of the same name
+namespace ShaderFeature {
+// Geometry, chosen by the renderer per draw
+constexpr std::uint32_t SKINNED = 1u << 0;
+constexpr std::uint32_t INSTANCED = 1u << 1;
+
+// Material, see Material::shaderFeatures
+constexpr std::uint32_t HAS_BASE_MAP = 1u << 2;
+constexpr std::uint32_t HAS_OVERLAY = 1u << 3;
+constexpr std::uint32_t ALPHA_TEST = 1u << 4;
+
+constexpr std::uint32_t COUNT = 5;
+} // namespace ShaderFeature
+
+// Builds program variants of one vertex/fragment pair from feature bits. Variants are compiled
+// the first time they are requested and cached by their bits, so every draw gets a program
+// without branches for features it does not use.
+class ShaderLibrary {
+public:
+	void setSources(std::string const& vertPath, std::string const& fragPath);
+
+	// Variant for `features`, compiled on first use
+	Shader* get(std::uint32_t features);
+
+	size_t variantCount() const { return variants_.size(); }
+
+	// Defines for `features`, e.g. {"SKINNED", "HAS_BASE_MAP"}
+	static std::vector<std::string> definesFor(std::uint32_t features);
+
+	void clear() { variants_.clear(); }
+
+private:
+	std::string vertPath_, fragPath_;
+	std::unordered_map<std::uint32_t, std::unique_ptr<Shader>> variants_;
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "include_5568ke.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "Shader.hpp"
+
+class Mesh;
+
+// Optional pre-skinning pass. Each skinned mesh drawn this frame is skinned once with transform
+// feedback into one shared buffer of SkinnedVertex; every pass after that draws its range as
+// static geometry (Mesh::skinnedVao + drawPrimitiveBaseVertex) instead of blending bones again.
+class SkinningStage {
+public:
+	SkinningStage() = default;
+	~SkinningStage();
+
+	SkinningStage(SkinningStage const&) = delete;
+	SkinningStage& operator=(SkinningStage const&) = delete;
+
+	// Build the feedback program and the output buffer, capacity grows on demand
+	void init(size_t vertices = 65536);
+
+	// Forget last frame's meshes
+	void beginFrame();
+
+	// Queue `mesh` for skinning with the palette at boneBase, returns its first vertex in the output buffer
+	int add(Mesh const& mesh, int boneBase);
+
+	// Skin everything queued this frame; the palette buffer must be bound. Queued bone bases are
+	// relative to `paletteBase` (see BonePaletteBuffer::segmentBase).
+	void run(int paletteBase);
+
+	bool ready() const { return shader_ && buffer_; }
+	GLuint outputBuffer() const { return buffer_; }
+
+	size_t meshesThisFrame() const { return jobs_.size(); }
+	size_t verticesThisFrame() const { return vertexCount_; }
+
+	void cleanup();
+
+private:
+	struct Job {
+		Mesh const* mesh = nullptr;
+		int boneBase = 0;
+		size_t baseVertex = 0;
+		size_t vertexCount = 0;
+	};
+
+	std::unique_ptr<Shader> shader_;
+	GLuint buffer_ = 0;
+	size_t capacity_ = 0; // vertices
+
+	std::vector<Job> jobs_;
+	size_t vertexCount_ = 0; // vertices queued this frame
+};
@@ -2,6 +2,8 @@
 
 #include "include_5568ke.hpp"
 
+#include "GLStateCache.hpp"
+
 #include <string>
 
 enum class TextureType { Diffuse, Specular, Normal, Roughness };
@@ -12,9 +14,5 @@ public:
 	TextureType type;
 	std::string path;
 
-	void bind(unsigned slot) const
-	{
-		glActiveTexture(GL_TEXTURE0 + slot);
-		glBindTexture(GL_TEXTURE_2D, id);
-	}
+	void bind(unsigned slot) const { GLStateCache::getInstance().bindTexture(slot, GL_TEXTURE_2D, id); }
 };
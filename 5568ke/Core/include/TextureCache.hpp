@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "Texture.hpp"
+
+// Textures shared by every material and model that samples the same image the same way. Entries
+// are reference counted; the GL texture is deleted when the last reference is released. Lookups
+// happen on import threads, so the cache is locked, but release() deletes GL objects and must run
+// on the GL thread.
+class TextureCache {
+public:
+	static TextureCache& getInstance()
+	{
+		static TextureCache instance;
+		return instance;
+	}
+
+	struct Key {
+		std::string file; // model file the image belongs to
+		int image = -1;		// glTF image index
+		int sampler = -1; // glTF sampler index, -1 for the default sampler
+
+		bool operator==(Key const& other) const = default;
+	};
+
+	struct Stats {
+		size_t hits = 0;
+		size_t misses = 0;
+	};
+
+	// Add a reference to the texture for `key`, creating it (with `type` and `path`) on a miss.
+	// `needsUpload` is set while no importer has uploaded it yet: another import may have created
+	// it and still be in flight, or may have been dropped, so every such caller stages its own
+	// upload and the first one to reach the GL thread wins (see markUploaded).
+	Texture* acquire(Key const& key, TextureType type, std::string const& path, bool& needsUpload);
+
+	// Record that `texture` has its GL storage; later acquires no longer stage uploads
+	void markUploaded(Texture* texture);
+
+	// Drop one reference taken by acquire()
+	void release(Texture* texture);
+
+	size_t size() const;
+	Stats stats() const;
+
+	// Delete every texture regardless of references (shutdown)
+	void cleanup();
+
+private:
+	TextureCache() = default;
+
+	struct KeyHash {
+		size_t operator()(Key const& key) const;
+	};
+
+	struct Entry {
+		std::unique_ptr<Texture> texture;
+		int references = 0;
+		bool uploaded = false;
+	};
+
+	mutable std::mutex mutex_;
+	std::unordered_map<Key, Entry, KeyHash> entries_;
+	std::unordered_map<Texture const*, Key> keys_; // reverse lookup for release()
+	Stats stats_;
+};
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// Fixed binding points for uniform blocks shared by every program.
+// GLSL 330 has no layout(binding = N), so Shader::reload() wires the blocks up by name.
+enum UniformBlockBinding : unsigned {
+	FRAME_DATA_BINDING = 0,
+};
+
+// std140 mirror of the FrameData block declared in the shaders
+struct FrameData {
+	glm::mat4 view;
+	glm::mat4 proj;
+	glm::vec4 viewPos;		// xyz = camera position
+	glm::vec4 lightPos;		// xyz = first light position
+	glm::vec4 lightColor; // rgb = color, a = intensity
+};
+
+static_assert(sizeof(FrameData) == 176, "FrameData must match the std140 layout of the GLSL block");
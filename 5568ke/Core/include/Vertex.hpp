@@ -1,5 +1,7 @@
 #pragma once
 
+#include <glm/mat3x3.hpp>
+#include <glm/mat4x4.hpp>
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
 #include "Animation.hpp"
@@ -11,4 +13,18 @@ struct Vertex {
 
 	// Bone data for skeletal animation
 	VertexBoneData boneData;
-};
\ No newline at end of file
+};
+
+// Vertex written by the pre-skinning pass (see SkinningStage), in model space. Transform
+// feedback packs interleaved outputs tightly, so this must stay free of padding.
+struct SkinnedVertex {
+	glm::vec3 position;
+	glm::vec3 normal;
+	glm::vec2 texcoord;
+};
+
+// Per-instance attributes of instanced static meshes (see Mesh::bindInstanceAttributes)
+struct InstanceData {
+	glm::mat4 model;
+	glm::mat3 normalMatrix;
+};
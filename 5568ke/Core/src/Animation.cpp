@@ -4,34 +4,38 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/quaternion.hpp>
 #include <algorithm>
+#include <cmath>
 #include <iostream>
 #include "Model.hpp"
+#include "PoseSampler.hpp"
 
-// Bone methods for keyframe interpolation
-int Bone::getPositionIndex(float animationTime) const
-{
-	if (positions.empty()) {
-		return -1;
-	}
+namespace {
+// Forward steps a cursor takes one by one before searching the rest of the track
+int const MAX_CURSOR_STEPS = 4;
 
+// Index of the last of `count` keys at or before `time` (clamped to the first/last key);
+// timeOf(k) returns the time of key k
+template <typename TimeOf>
+int binarySearchKey(int count, float time, TimeOf timeOf)
+{
 	// Handle edge cases
-	if (positions.size() == 1 || animationTime <= positions[0].timeStamp) {
+	if (count == 1 || time <= timeOf(0)) {
 		return 0;
 	}
 
-	if (animationTime >= positions.back().timeStamp) {
-		return static_cast<int>(positions.size() - 1);
+	if (time >= timeOf(count - 1)) {
+		return count - 1;
 	}
 
-	// Binary search for the correct position
 	int left = 0;
-	int right = static_cast<int>(positions.size() - 1);
+	int right = count - 1;
 	while (left <= right) {
 		int mid = left + (right - left) / 2;
-		if (positions[mid].timeStamp == animationTime) {
+		float const midTime = timeOf(mid);
+		if (midTime == time) {
 			return mid;
 		}
-		if (positions[mid].timeStamp < animationTime) {
+		if (midTime < time) {
 			left = mid + 1;
 		}
 		else {
@@ -39,75 +43,253 @@ int Bone::getPositionIndex(float animationTime) const
 		}
 	}
 
-	// At this point, left > right and animationTime is between [right] and [left]
+	// At this point, left > right and time is between [right] and [left]
 	return right;
 }
 
-int Bone::getRotationIndex(float animationTime) const
+// Same as binarySearchKey, but starts from the key used last time. During forward playback the
+// answer is the cursor itself or a key or two later, so this is O(1). Longer forward jumps only
+// search the keys after the cursor; going backwards (seek, loop wrap) searches the whole track.
+template <typename TimeOf>
+int advanceKey(int count, float time, int& cursor, TimeOf timeOf)
 {
-	if (rotations.empty()) {
-		return -1;
+	int const last = count - 1;
+	if (cursor < 0 || cursor > last || timeOf(cursor) > time) {
+		cursor = binarySearchKey(count, time, timeOf);
+		return cursor;
+	}
+
+	for (int step = 0; step < MAX_CURSOR_STEPS; step++) {
+		if (cursor == last || timeOf(cursor + 1) > time)
+			return cursor;
+		cursor++;
+	}
+
+	// First key after `time` among the remaining ones, the answer is the one before it
+	int left = cursor + 1;
+	int right = count;
+	while (left < right) {
+		int const mid = left + (right - left) / 2;
+		if (time < timeOf(mid))
+			right = mid;
+		else
+			left = mid + 1;
 	}
+	cursor = left - 1;
+	return cursor;
+}
 
-	if (rotations.size() == 1 || animationTime <= rotations[0].timeStamp) {
-		return 0;
+template <typename Key>
+int binarySearchKey(std::vector<Key> const& keys, float time)
+{
+	return binarySearchKey(static_cast<int>(keys.size()), time, [&keys](int k) { return keys[k].timeStamp; });
+}
+
+template <typename Key>
+int advanceKey(std::vector<Key> const& keys, float time, int& cursor)
+{
+	return advanceKey(static_cast<int>(keys.size()), time, cursor, [&keys](int k) { return keys[k].timeStamp; });
+}
+
+// Compressed channels index into the clip's shared key times
+int advanceKey(std::vector<std::uint16_t> const& times, std::vector<float> const& keyTimes, float time, int& cursor)
+{
+	if (times.empty())
+		return -1;
+	return advanceKey(static_cast<int>(times.size()), time, cursor, [&](int k) { return keyTimes[times[k]]; });
+}
+
+// Advance a clip's time by dt seconds, wrapping (and re-searching the tracks) or holding the end
+float advanceClipTime(AnimationClip const& clip, float time, float dt, bool loop, std::vector<TrackCursor>& cursors)
+{
+	if (clip.duration <= 0.0f)
+		return 0.0f;
+
+	time += dt * clip.ticksPerSecond;
+	if (time >= clip.duration) {
+		if (!loop)
+			return clip.duration;
+		time = std::fmod(time, clip.duration);
+		std::fill(cursors.begin(), cursors.end(), TrackCursor{});
 	}
+	return time;
+}
+
+// Weight of one bone under a mask, an empty mask selects every bone
+float maskWeight(std::vector<float> const& mask, size_t bone, float weight)
+{
+	if (mask.empty())
+		return weight;
+	return bone < mask.size() ? weight * mask[bone] : 0.0f;
+}
 
-	if (animationTime >= rotations.back().timeStamp) {
-		return static_cast<int>(rotations.size() - 1);
+// dst = mix(dst, src, weight) per bone: lerp for translation/scale, nlerp for rotation
+void blendPoses(Pose& dst, Pose const& src, float weight, std::vector<float> const& mask)
+{
+	size_t const count = std::min(dst.size(), src.size());
+	for (size_t i = 0; i < count; i++) {
+		float const w = maskWeight(mask, i, weight);
+		if (w <= 0.0f)
+			continue;
+		dst.translations[i] = glm::mix(dst.translations[i], src.translations[i], w);
+		dst.rotations[i] = nlerpShortest(dst.rotations[i], src.rotations[i], w);
+		dst.scales[i] = glm::mix(dst.scales[i], src.scales[i], w);
 	}
+}
 
-	int left = 0;
-	int right = static_cast<int>(rotations.size() - 1);
-	while (left <= right) {
-		int mid = left + (right - left) / 2;
-		if (rotations[mid].timeStamp == animationTime) {
-			return mid;
-		}
-		if (rotations[mid].timeStamp < animationTime) {
-			left = mid + 1;
-		}
-		else {
-			right = mid - 1;
+// Add src's motion relative to ref (its first frame) on top of dst, scaled by weight
+void addPose(Pose& dst, Pose const& src, Pose const& ref, float weight, std::vector<float> const& mask)
+{
+	glm::quat const identity(1.0f, 0.0f, 0.0f, 0.0f);
+	size_t const count = std::min({dst.size(), src.size(), ref.size()});
+	for (size_t i = 0; i < count; i++) {
+		float const w = maskWeight(mask, i, weight);
+		if (w <= 0.0f)
+			continue;
+		dst.translations[i] += w * (src.translations[i] - ref.translations[i]);
+
+		glm::quat const delta = glm::inverse(ref.rotations[i]) * src.rotations[i];
+		dst.rotations[i] = glm::normalize(dst.rotations[i] * nlerpShortest(identity, delta, w));
+
+		glm::vec3 ratio(1.0f);
+		for (int c = 0; c < 3; c++) {
+			if (ref.scales[i][c] != 0.0f)
+				ratio[c] = src.scales[i][c] / ref.scales[i][c];
 		}
+		dst.scales[i] *= glm::mix(glm::vec3(1.0f), ratio, w);
 	}
-
-	return right;
 }
 
-int Bone::getScaleIndex(float animationTime) const
+// Range of the three smallest components of a unit quaternion, and the quantization scale
+float const QUAT_COMPONENT_RANGE = 0.70710678f;
+float const QUAT_COMPONENT_STEPS = 32767.0f;
+
+// Split skinning matrices into translation, rotation and scale so the LOD can blend them without
+// shrinking rotations. Shear (non-uniform scale under rotation in the hierarchy) is dropped.
+void decomposePalette(std::vector<glm::mat4> const& palette, Pose& out)
 {
-	if (scales.empty()) {
-		return -1;
-	}
+	out.resize(palette.size());
+	for (size_t bone = 0; bone < palette.size(); bone++) {
+		glm::mat4 const& m = palette[bone];
+		glm::vec3 const scale(glm::length(glm::vec3(m[0])), glm::length(glm::vec3(m[1])), glm::length(glm::vec3(m[2])));
+		glm::vec3 const safe = glm::max(scale, glm::vec3(1e-8f));
+		glm::mat3 const rotation(glm::vec3(m[0]) / safe.x, glm::vec3(m[1]) / safe.y, glm::vec3(m[2]) / safe.z);
 
-	if (scales.size() == 1 || animationTime <= scales[0].timeStamp) {
-		return 0;
+		out.translations[bone] = glm::vec3(m[3]);
+		out.rotations[bone] = glm::normalize(glm::quat_cast(rotation));
+		out.scales[bone] = scale;
 	}
+}
+} // namespace
 
-	if (animationTime >= scales.back().timeStamp) {
-		return static_cast<int>(scales.size() - 1);
+// PackedQuat: 48-bit layout is [largest index:2][a:15][b:15][c:15], 1 bit unused
+PackedQuat PackedQuat::pack(glm::quat const& q)
+{
+	float const c[4] = {q.x, q.y, q.z, q.w};
+	int largest = 0;
+	for (int i = 1; i < 4; i++) {
+		if (std::abs(c[i]) > std::abs(c[largest]))
+			largest = i;
 	}
 
-	int left = 0;
-	int right = static_cast<int>(scales.size() - 1);
-	while (left <= right) {
-		int mid = left + (right - left) / 2;
-		if (scales[mid].timeStamp == animationTime) {
-			return mid;
-		}
-		if (scales[mid].timeStamp < animationTime) {
-			left = mid + 1;
-		}
-		else {
-			right = mid - 1;
-		}
+	// q and -q are the same rotation, keep the one with a positive largest component
+	float const sign = c[largest] < 0.0f ? -1.0f : 1.0f;
+
+	std::uint64_t packed = static_cast<std::uint64_t>(largest);
+	for (int i = 0; i < 4; i++) {
+		if (i == largest)
+			continue;
+		float const normalized = std::clamp(c[i] * sign / QUAT_COMPONENT_RANGE, -1.0f, 1.0f) * 0.5f + 0.5f;
+		packed = (packed << 15) | static_cast<std::uint64_t>(std::lround(normalized * QUAT_COMPONENT_STEPS));
 	}
 
-	return right;
+	PackedQuat result;
+	result.bits[0] = static_cast<std::uint16_t>(packed >> 32);
+	result.bits[1] = static_cast<std::uint16_t>(packed >> 16);
+	result.bits[2] = static_cast<std::uint16_t>(packed);
+	return result;
+}
+
+glm::quat PackedQuat::unpack() const
+{
+	std::uint64_t const packed = (static_cast<std::uint64_t>(bits[0]) << 32) | (static_cast<std::uint64_t>(bits[1]) << 16) | bits[2];
+	int const largest = static_cast<int>((packed >> 45) & 3);
+
+	float c[4];
+	float sumSquares = 0.0f;
+	int shift = 30;
+	for (int i = 0; i < 4; i++) {
+		if (i == largest)
+			continue;
+		float const quantized = static_cast<float>((packed >> shift) & 0x7FFF) / QUAT_COMPONENT_STEPS;
+		c[i] = (quantized * 2.0f - 1.0f) * QUAT_COMPONENT_RANGE;
+		sumSquares += c[i] * c[i];
+		shift -= 15;
+	}
+	c[largest] = std::sqrt(std::max(0.0f, 1.0f - sumSquares));
+
+	return glm::quat(c[3], c[0], c[1], c[2]);
+}
+
+glm::quat nlerpShortest(glm::quat const& a, glm::quat const& b, float t)
+{
+	float const sign = a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w < 0.0f ? -1.0f : 1.0f;
+	float const x = a.x + t * (sign * b.x - a.x);
+	float const y = a.y + t * (sign * b.y - a.y);
+	float const z = a.z + t * (sign * b.z - a.z);
+	float const w = a.w + t * (sign * b.w - a.w);
+	float const invLength = 1.0f / std::sqrt(x * x + y * y + z * z + w * w);
+	return glm::quat(w * invLength, x * invLength, y * invLength, z * invLength);
+}
+
+// CompressedTrack key lookups
+int CompressedTrack::positionKey(std::vector<float> const& keyTimes, float animationTime, int& cursor) const
+{
+	return advanceKey(positionTimes, keyTimes, animationTime, cursor);
+}
+
+int CompressedTrack::rotationKey(std::vector<float> const& keyTimes, float animationTime, int& cursor) const
+{
+	return advanceKey(rotationTimes, keyTimes, animationTime, cursor);
+}
+
+int CompressedTrack::scaleKey(std::vector<float> const& keyTimes, float animationTime, int& cursor) const
+{
+	return advanceKey(scaleTimes, keyTimes, animationTime, cursor);
+}
+
+// BoneTrack methods for keyframe interpolation
+int BoneTrack::getPositionIndex(float animationTime) const { return positions.empty() ? -1 : binarySearchKey(positions, animationTime); }
+
+int BoneTrack::getRotationIndex(float animationTime) const { return rotations.empty() ? -1 : binarySearchKey(rotations, animationTime); }
+
+int BoneTrack::getScaleIndex(float animationTime) const { return scales.empty() ? -1 : binarySearchKey(scales, animationTime); }
+
+int BoneTrack::positionKey(float animationTime, int& cursor) const { return positions.empty() ? -1 : advanceKey(positions, animationTime, cursor); }
+
+int BoneTrack::rotationKey(float animationTime, int& cursor) const { return rotations.empty() ? -1 : advanceKey(rotations, animationTime, cursor); }
+
+int BoneTrack::scaleKey(float animationTime, int& cursor) const { return scales.empty() ? -1 : advanceKey(scales, animationTime, cursor); }
+
+glm::vec3 BoneTrack::interpolatePosition(float animationTime) const
+{
+	int cursor = -1;
+	return interpolatePosition(animationTime, cursor);
 }
 
-glm::vec3 Bone::interpolatePosition(float animationTime) const
+glm::quat BoneTrack::interpolateRotation(float animationTime) const
+{
+	int cursor = -1;
+	return interpolateRotation(animationTime, cursor);
+}
+
+glm::vec3 BoneTrack::interpolateScale(float animationTime) const
+{
+	int cursor = -1;
+	return interpolateScale(animationTime, cursor);
+}
+
+glm::vec3 BoneTrack::interpolatePosition(float animationTime, int& cursor) const
 {
 	if (positions.empty()) {
 		return glm::vec3(0.0f);
@@ -117,14 +299,10 @@ glm::vec3 Bone::interpolatePosition(float animationTime) const
 		return positions[0].position;
 	}
 
-	int p0Index = getPositionIndex(animationTime);
+	int p0Index = advanceKey(positions, animationTime, cursor);
 	int p1Index = p0Index + 1;
 
 	// Handle edge cases
-	if (p0Index == -1) {
-		return glm::vec3(0.0f);
-	}
-
 	if (p0Index == static_cast<int>(positions.size() - 1)) {
 		return positions[p0Index].position;
 	}
@@ -135,7 +313,7 @@ glm::vec3 Bone::interpolatePosition(float animationTime) const
 	return glm::mix(positions[p0Index].position, positions[p1Index].position, scaleFactor);
 }
 
-glm::quat Bone::interpolateRotation(float animationTime) const
+glm::quat BoneTrack::interpolateRotation(float animationTime, int& cursor) const
 {
 	if (rotations.empty()) {
 		return glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
@@ -145,14 +323,10 @@ glm::quat Bone::interpolateRotation(float animationTime) const
 		return rotations[0].orientation;
 	}
 
-	int r0Index = getRotationIndex(animationTime);
+	int r0Index = advanceKey(rotations, animationTime, cursor);
 	int r1Index = r0Index + 1;
 
 	// Handle edge cases
-	if (r0Index == -1) {
-		return glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
-	}
-
 	if (r0Index == static_cast<int>(rotations.size() - 1)) {
 		return rotations[r0Index].orientation;
 	}
@@ -163,7 +337,7 @@ glm::quat Bone::interpolateRotation(float animationTime) const
 	return glm::slerp(rotations[r0Index].orientation, rotations[r1Index].orientation, scaleFactor);
 }
 
-glm::vec3 Bone::interpolateScale(float animationTime) const
+glm::vec3 BoneTrack::interpolateScale(float animationTime, int& cursor) const
 {
 	if (scales.empty()) {
 		return glm::vec3(1.0f);
@@ -173,14 +347,10 @@ glm::vec3 Bone::interpolateScale(float animationTime) const
 		return scales[0].scale;
 	}
 
-	int s0Index = getScaleIndex(animationTime);
+	int s0Index = advanceKey(scales, animationTime, cursor);
 	int s1Index = s0Index + 1;
 
 	// Handle edge cases
-	if (s0Index == -1) {
-		return glm::vec3(1.0f);
-	}
-
 	if (s0Index == static_cast<int>(scales.size() - 1)) {
 		return scales[s0Index].scale;
 	}
@@ -191,11 +361,17 @@ glm::vec3 Bone::interpolateScale(float animationTime) const
 	return glm::mix(scales[s0Index].scale, scales[s1Index].scale, scaleFactor);
 }
 
-glm::mat4 Bone::calculateLocalTransform(float animationTime)
+glm::mat4 BoneTrack::calculateLocalTransform(float animationTime) const
 {
-	glm::vec3 position = interpolatePosition(animationTime);
-	glm::quat rotation = interpolateRotation(animationTime);
-	glm::vec3 scale = interpolateScale(animationTime);
+	TrackCursor cursor;
+	return calculateLocalTransform(animationTime, cursor);
+}
+
+glm::mat4 BoneTrack::calculateLocalTransform(float animationTime, TrackCursor& cursor) const
+{
+	glm::vec3 position = interpolatePosition(animationTime, cursor.position);
+	glm::quat rotation = interpolateRotation(animationTime, cursor.rotation);
+	glm::vec3 scale = interpolateScale(animationTime, cursor.scale);
 
 	// Create transformation matrix from components
 	glm::mat4 translation = glm::translate(glm::mat4(1.0f), position);
@@ -203,18 +379,117 @@ glm::mat4 Bone::calculateLocalTransform(float animationTime)
 	glm::mat4 scale_mat = glm::scale(glm::mat4(1.0f), scale);
 
 	// Combine transforms: T * R * S
-	localTransform = translation * rotation_mat * scale_mat;
-	return localTransform;
+	return translation * rotation_mat * scale_mat;
 }
 
-// AnimationPlayer implementation
-void AnimationPlayer::initialize(Model* model)
+// Skeleton helpers
+void Skeleton::finalize()
+{
+	// Children follow their parents, so a reverse pass sees every child before its parent
+	nodeHeights.assign(nodeCount(), 0);
+	for (size_t node = nodeCount(); node-- > 0;) {
+		int const parent = nodeParents[node];
+		if (parent >= 0)
+			nodeHeights[parent] = std::max(nodeHeights[parent], nodeHeights[node] + 1);
+	}
+
+	restPose = Pose();
+	restPose.resize(bones.size());
+
+	for (size_t node = 0; node < nodeCount(); node++) {
+		int const bone = nodeBones[node];
+		if (bone < 0 || bone >= static_cast<int>(bones.size()))
+			continue;
+
+		glm::mat4 const& m = nodeRestTransforms[node];
+		glm::vec3 const c0(m[0]), c1(m[1]), c2(m[2]);
+		glm::vec3 const scale(glm::length(c0), glm::length(c1), glm::length(c2));
+
+		restPose.translations[bone] = glm::vec3(m[3]);
+		restPose.scales[bone] = scale;
+		if (scale.x > 0.0f && scale.y > 0.0f && scale.z > 0.0f)
+			restPose.rotations[bone] = glm::normalize(glm::quat_cast(glm::mat3(c0 / scale.x, c1 / scale.y, c2 / scale.z)));
+	}
+}
+
+AnimationLod AnimationLodPolicy::select(float screenFraction, AnimationLod const& current) const
+{
+	if (!enabled)
+		return AnimationLod();
+
+	// Coarsen only once the entity is clearly below a threshold, refine only once clearly above:
+	// keep the current level if it is right for any size within the band
+	int const level = levelOf_(current);
+	int const minLevel = levelFor_(screenFraction * (1.0f + hysteresis));
+	int const maxLevel = levelFor_(screenFraction * (1.0f - hysteresis));
+	return lodFor_(std::clamp(level, minLevel, maxLevel));
+}
+
+int AnimationLodPolicy::levelFor_(float screenFraction) const
+{
+	if (screenFraction >= halfRateBelow)
+		return 0;
+	if (screenFraction >= quarterRateBelow)
+		return 1;
+	if (screenFraction >= minimalBelow)
+		return 2;
+	return 3;
+}
+
+AnimationLod AnimationLodPolicy::lodFor_(int level)
+{
+	AnimationLod lod;
+	if (level == 1) {
+		lod.updateInterval = 2;
+	}
+	else if (level == 2) {
+		lod.updateInterval = 4;
+		lod.skipBoneHeight = 0;
+	}
+	else if (level == 3) {
+		lod.updateInterval = 8;
+		lod.skipBoneHeight = 1;
+	}
+	return lod;
+}
+
+int AnimationLodPolicy::levelOf_(AnimationLod const& lod)
+{
+	for (int level = 1; level <= 3; level++) {
+		if (lodFor_(level) == lod)
+			return level;
+	}
+	return 0;
+}
+
+std::vector<float> Skeleton::makeBoneMask(int rootBone) const
+{
+	std::vector<float> mask(bones.size(), 0.0f);
+	std::vector<char> selected(nodeCount(), 0);
+
+	// Parents precede children, so one pass marks the whole subtree
+	for (size_t node = 0; node < nodeCount(); node++) {
+		int const parent = nodeParents[node];
+		selected[node] = nodeBones[node] == rootBone || (parent >= 0 && selected[parent]);
+		if (selected[node] && nodeBones[node] >= 0)
+			mask[nodeBones[node]] = 1.0f;
+	}
+	return mask;
+}
+
+// AnimationInstance implementation
+void AnimationInstance::initialize(Model const* model)
 {
 	model_ = model;
 	currentAnimation_ = nullptr;
 	currentAnimationIndex_ = -1;
 	currentTime_ = 0.0f;
 	playing_ = false;
+	fadeFrom_ = nullptr;
+	layers_.clear();
+	lod_ = AnimationLod();
+	activeBones_.clear();
+	resetPalette_();
 
 	// Set default animation if available
 	if (model_ && !model_->animations.empty()) {
@@ -222,8 +497,9 @@ void AnimationPlayer::initialize(Model* model)
 	}
 }
 
-void AnimationPlayer::update(float dt)
+void AnimationInstance::update(float dt)
 {
+	evaluatedBones_ = 0;
 	if (!model_ || !currentAnimation_ || !playing_) {
 		return;
 	}
@@ -235,20 +511,101 @@ void AnimationPlayer::update(float dt)
 	if (currentTime_ >= currentAnimation_->duration) {
 		if (looping_) {
 			currentTime_ = fmod(currentTime_, currentAnimation_->duration);
+			resetCursors_();
 		}
 		else {
+			// Hold the last frame; an unfinished crossfade keeps running and stops playback when it completes
 			currentTime_ = currentAnimation_->duration;
-			playing_ = false;
+			if (!fadeFrom_)
+				playing_ = false;
 		}
 	}
 
+	// The outgoing clip keeps playing until the crossfade completes
+	if (fadeFrom_) {
+		fadeElapsed_ += dt * playbackSpeed_;
+		if (fadeElapsed_ >= fadeDuration_) {
+			fadeFrom_ = nullptr;
+			if (!looping_ && currentTime_ >= currentAnimation_->duration)
+				playing_ = false;
+		}
+		else
+			fadeFromTime_ = advanceClipTime(*fadeFrom_, fadeFromTime_, dt * playbackSpeed_, looping_, fadeCursors_);
+	}
+
+	// Layers always loop
+	for (AnimationLayer& layer : layers_)
+		layer.time = advanceClipTime(*layer.clip, layer.time, dt * playbackSpeed_, true, layer.cursors);
+
 	// Update bone transformations
-	if (currentAnimation_->rootNode) {
-		updateBoneTransforms(currentTime_, currentAnimation_->rootNode, glm::mat4(1.0f), model_->skeleton);
+	if (lod_.updateInterval <= 1) {
+		evaluatePose_(currentTime_);
+		return;
+	}
+
+	// Reduced rate: between evaluations move the palette from the previous evaluation toward the
+	// latest one. The pose shown lags one interval behind, which is invisible at the sizes this
+	// LOD is used for, and blending skinning transforms is far cheaper than sampling and the hierarchy.
+	if (lodValid_ && playing_ && ++lodTick_ < lod_.updateInterval) {
+		blendLodPalette_(static_cast<float>(lodTick_) / static_cast<float>(lod_.updateInterval));
+		return;
+	}
+
+	evaluatePose_(currentTime_);
+	if (!lodValid_)
+		decomposePalette(palette_, lodTo_);
+	std::swap(lodFrom_, lodTo_);
+	decomposePalette(palette_, lodTo_);
+	blendLodPalette_(0.0f);
+	lodTick_ = 0;
+	lodValid_ = true;
+}
+
+void AnimationInstance::blendLodPalette_(float t)
+{
+	for (size_t bone = 0; bone < palette_.size(); bone++) {
+		glm::vec3 const translation = glm::mix(lodFrom_.translations[bone], lodTo_.translations[bone], t);
+		glm::quat const rotation = nlerpShortest(lodFrom_.rotations[bone], lodTo_.rotations[bone], t);
+		glm::vec3 const scale = glm::mix(lodFrom_.scales[bone], lodTo_.scales[bone], t);
+
+		glm::mat4 matrix = glm::mat4_cast(rotation);
+		matrix[0] *= scale.x;
+		matrix[1] *= scale.y;
+		matrix[2] *= scale.z;
+		matrix[3] = glm::vec4(translation, 1.0f);
+		palette_[bone] = matrix;
+	}
+}
+
+void AnimationInstance::setTick(std::uint64_t tick)
+{
+	if (tick != lastTick_ + 1)
+		lodValid_ = false;
+	lastTick_ = tick;
+}
+
+void AnimationInstance::setLod(AnimationLod const& lod)
+{
+	if (lod == lod_) {
+		return;
+	}
+	lod_ = lod;
+	lodValid_ = false;
+
+	// Bones whose subtree is short enough are not sampled
+	activeBones_.clear();
+	if (lod_.skipBoneHeight >= 0 && model_) {
+		Skeleton const& skeleton = model_->skeleton;
+		activeBones_.assign(skeleton.bones.size(), 1);
+		for (size_t node = 0; node < skeleton.nodeCount() && node < skeleton.nodeHeights.size(); node++) {
+			int const bone = skeleton.nodeBones[node];
+			if (bone >= 0 && skeleton.nodeHeights[node] <= lod_.skipBoneHeight)
+				activeBones_[bone] = 0;
+		}
 	}
 }
 
-bool AnimationPlayer::setAnimation(int index)
+bool AnimationInstance::setAnimation(int index)
 {
 	if (!model_ || index < 0 || index >= static_cast<int>(model_->animations.size())) {
 		return false;
@@ -257,10 +614,13 @@ bool AnimationPlayer::setAnimation(int index)
 	currentAnimation_ = &model_->animations[index];
 	currentAnimationIndex_ = index;
 	currentTime_ = 0.0f;
+	fadeFrom_ = nullptr;
+	lodValid_ = false;
+	resetCursors_();
 	return true;
 }
 
-bool AnimationPlayer::setAnimation(std::string const& name)
+bool AnimationInstance::setAnimation(std::string const& name)
 {
 	if (!model_) {
 		return false;
@@ -275,7 +635,82 @@ bool AnimationPlayer::setAnimation(std::string const& name)
 	return false;
 }
 
-void AnimationPlayer::play()
+bool AnimationInstance::crossfadeTo(int index, float seconds)
+{
+	if (seconds <= 0.0f || !currentAnimation_ || index == currentAnimationIndex_) {
+		return setAnimation(index);
+	}
+
+	// Restarting a fade drops the clip that was fading out before
+	AnimationClip const* outgoing = currentAnimation_;
+	float const outgoingTime = currentTime_;
+	std::vector<TrackCursor> outgoingCursors = cursors_;
+	if (!setAnimation(index)) {
+		return false;
+	}
+
+	fadeFrom_ = outgoing;
+	fadeFromTime_ = outgoingTime;
+	fadeCursors_ = std::move(outgoingCursors);
+	fadeDuration_ = seconds;
+	fadeElapsed_ = 0.0f;
+	return true;
+}
+
+bool AnimationInstance::crossfadeTo(std::string const& name, float seconds)
+{
+	if (!model_) {
+		return false;
+	}
+
+	for (size_t i = 0; i < model_->animations.size(); i++) {
+		if (model_->animations[i].name == name) {
+			return crossfadeTo(static_cast<int>(i), seconds);
+		}
+	}
+
+	return false;
+}
+
+int AnimationInstance::addLayer(int clipIndex, LayerBlend blend, float weight, std::vector<float> boneMask)
+{
+	if (!model_ || clipIndex < 0 || clipIndex >= static_cast<int>(model_->animations.size())) {
+		return -1;
+	}
+
+	AnimationLayer layer;
+	layer.clip = &model_->animations[clipIndex];
+	layer.blend = blend;
+	layer.weight = std::clamp(weight, 0.0f, 1.0f);
+	layer.boneMask = std::move(boneMask);
+	layer.cursors.assign(model_->skeleton.bones.size(), TrackCursor{});
+
+	// Additive layers add their motion relative to the first frame
+	if (blend == LayerBlend::Additive) {
+		PoseSampler sampler;
+		std::vector<TrackCursor> cursors;
+		sampler.samplePose(*layer.clip, 0.0f, cursors, model_->skeleton.restPose, layer.referencePose);
+	}
+
+	layers_.push_back(std::move(layer));
+	return static_cast<int>(layers_.size() - 1);
+}
+
+void AnimationInstance::removeLayer(int layer)
+{
+	if (layer >= 0 && layer < static_cast<int>(layers_.size())) {
+		layers_.erase(layers_.begin() + layer);
+	}
+}
+
+void AnimationInstance::setLayerWeight(int layer, float weight)
+{
+	if (layer >= 0 && layer < static_cast<int>(layers_.size())) {
+		layers_[layer].weight = std::clamp(weight, 0.0f, 1.0f);
+	}
+}
+
+void AnimationInstance::play()
 {
 	if (currentAnimation_) {
 		playing_ = true;
@@ -283,24 +718,24 @@ void AnimationPlayer::play()
 		// If we're at the end and not looping, restart
 		if (currentTime_ >= currentAnimation_->duration && !looping_) {
 			currentTime_ = 0.0f;
+			resetCursors_();
 		}
 	}
 }
 
-void AnimationPlayer::pause() { playing_ = false; }
+void AnimationInstance::pause() { playing_ = false; }
 
-void AnimationPlayer::stop()
+void AnimationInstance::stop()
 {
 	playing_ = false;
 	currentTime_ = 0.0f;
+	fadeFrom_ = nullptr;
 
 	// Reset bone transformations to bind pose
-	if (model_) {
-		model_->skeleton.finalBoneMatrices.assign(Skeleton::MAX_BONES, glm::mat4(1.0f));
-	}
+	resetPalette_();
 }
 
-std::string AnimationPlayer::getCurrentAnimationName() const
+std::string AnimationInstance::getCurrentAnimationName() const
 {
 	if (currentAnimation_) {
 		return currentAnimation_->name;
@@ -308,7 +743,7 @@ std::string AnimationPlayer::getCurrentAnimationName() const
 	return "";
 }
 
-size_t AnimationPlayer::getAnimationCount() const
+size_t AnimationInstance::getAnimationCount() const
 {
 	if (model_) {
 		return model_->animations.size();
@@ -316,7 +751,7 @@ size_t AnimationPlayer::getAnimationCount() const
 	return 0;
 }
 
-std::string AnimationPlayer::getAnimationName(int index) const
+std::string AnimationInstance::getAnimationName(int index) const
 {
 	if (model_ && index >= 0 && index < static_cast<int>(model_->animations.size())) {
 		return model_->animations[index].name;
@@ -324,7 +759,7 @@ std::string AnimationPlayer::getAnimationName(int index) const
 	return "";
 }
 
-float AnimationPlayer::getCurrentDuration() const
+float AnimationInstance::getCurrentDuration() const
 {
 	if (currentAnimation_) {
 		return currentAnimation_->duration / currentAnimation_->ticksPerSecond;
@@ -332,7 +767,7 @@ float AnimationPlayer::getCurrentDuration() const
 	return 0.0f;
 }
 
-float AnimationPlayer::getProgress() const
+float AnimationInstance::getProgress() const
 {
 	if (currentAnimation_ && currentAnimation_->duration > 0.0f) {
 		return currentTime_ / currentAnimation_->duration;
@@ -340,45 +775,88 @@ float AnimationPlayer::getProgress() const
 	return 0.0f;
 }
 
-void AnimationPlayer::setProgress(float progress)
+void AnimationInstance::setProgress(float progress)
 {
 	if (currentAnimation_) {
 		progress = std::clamp(progress, 0.0f, 1.0f);
 		currentTime_ = progress * currentAnimation_->duration;
+		lodValid_ = false;
+		resetCursors_();
 
 		// Update bone transformations immediately
-		if (currentAnimation_->rootNode) {
-			updateBoneTransforms(currentTime_, currentAnimation_->rootNode, glm::mat4(1.0f), model_->skeleton);
-		}
+		evaluatePose_(currentTime_);
 	}
 }
 
-void AnimationPlayer::updateBoneTransforms(float animationTime, SkeletonNode* node, glm::mat4 const& parentTransform, Skeleton& skeleton)
+void AnimationInstance::evaluatePose_(float animationTime)
 {
-	if (!node) {
-		return;
+	Skeleton const& skeleton = model_->skeleton;
+	size_t const nodeCount = skeleton.nodeCount();
+
+	// Sample every track of the clip in one batch; the scratch is per thread, not per instance.
+	// Crossfades and layers go through the local pose blend, a single clip is composed directly.
+	static thread_local PoseSampler sampler;
+	bool const blended = fadeFrom_ != nullptr || !layers_.empty();
+	std::vector<std::uint8_t> const* active = activeBones_.empty() ? nullptr : &activeBones_;
+	if (blended)
+		blendPose_(animationTime, sampler);
+	else
+		sampler.sample(*currentAnimation_, animationTime, cursors_, active, &skeleton.restPose);
+	std::vector<glm::mat4> const& locals = sampler.locals();
+	evaluatedBones_ = active ? static_cast<size_t>(std::count(activeBones_.begin(), activeBones_.end(), 1)) : skeleton.bones.size();
+
+	// Parents precede children, so each parent's global transform is ready when its children need it
+	for (size_t node = 0; node < nodeCount; node++) {
+		int const boneIndex = skeleton.nodeBones[node];
+
+		// Bones animated by this clip sample their track, everything else (including bones the LOD
+		// skips) keeps its rest transform; a blended pose already holds the rest values for those
+		glm::mat4 local = skeleton.nodeRestTransforms[node];
+		if (boneIndex >= 0 && (blended || (currentAnimation_->animates(boneIndex) && (!active || (*active)[boneIndex]))))
+			local = locals[boneIndex];
+
+		int const parent = skeleton.nodeParents[node];
+		nodeGlobals_[node] = parent >= 0 ? nodeGlobals_[parent] * local : local;
+
+		if (boneIndex >= 0)
+			palette_[boneIndex] = nodeGlobals_[node] * skeleton.bones[boneIndex].offsetMatrix;
 	}
+}
 
-	// Get node transformation
-	glm::mat4 nodeTransform = node->transformation;
+void AnimationInstance::blendPose_(float animationTime, PoseSampler& sampler)
+{
+	Pose const& rest = model_->skeleton.restPose;
+	std::vector<std::uint8_t> const* active = activeBones_.empty() ? nullptr : &activeBones_;
+	sampler.samplePose(*currentAnimation_, animationTime, cursors_, rest, pose_, active);
 
-	// If node corresponds to a bone, calculate animation transform
-	if (node->boneIndex >= 0) {
-		Bone& bone = skeleton.bones[node->boneIndex];
-		nodeTransform = bone.calculateLocalTransform(animationTime);
+	// Crossfade: the outgoing clip's weight falls linearly from 1 to 0
+	if (fadeFrom_) {
+		sampler.samplePose(*fadeFrom_, fadeFromTime_, fadeCursors_, rest, layerPose_, active);
+		float const fade = fadeDuration_ > 0.0f ? std::clamp(fadeElapsed_ / fadeDuration_, 0.0f, 1.0f) : 1.0f;
+		blendPoses(pose_, layerPose_, 1.0f - fade, {});
 	}
 
-	// Calculate global transformation
-	glm::mat4 globalTransform = parentTransform * nodeTransform;
+	for (AnimationLayer& layer : layers_) {
+		if (layer.weight <= 0.0f)
+			continue;
 
-	// If node corresponds to a bone, update final bone matrix
-	if (node->boneIndex >= 0) {
-		Bone& bone = skeleton.bones[node->boneIndex];
-		skeleton.finalBoneMatrices[node->boneIndex] = globalTransform * bone.offsetMatrix;
+		sampler.samplePose(*layer.clip, layer.time, layer.cursors, rest, layerPose_, active);
+		if (layer.blend == LayerBlend::Additive)
+			addPose(pose_, layerPose_, layer.referencePose, layer.weight, layer.boneMask);
+		else
+			blendPoses(pose_, layerPose_, layer.weight, layer.boneMask);
 	}
 
-	// Process children
-	for (auto child : node->children) {
-		updateBoneTransforms(animationTime, child, globalTransform, skeleton);
-	}
-}
\ No newline at end of file
+	sampler.compose(pose_);
+}
+
+void AnimationInstance::resetPalette_()
+{
+	// One matrix per bone (palettes are streamed, there is no fixed cap)
+	palette_.assign(model_ ? model_->skeleton.bones.size() : 0, glm::mat4(1.0f));
+	lodValid_ = false;
+	nodeGlobals_.assign(model_ ? model_->skeleton.nodeCount() : 0, glm::mat4(1.0f));
+	resetCursors_();
+}
+
+void AnimationInstance::resetCursors_() { cursors_.assign(model_ ? model_->skeleton.bones.size() : 0, TrackCursor{}); }
@@ -0,0 +1,211 @@
+#include "AnimationCompression.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+#include "PoseSampler.hpp"
+
+namespace {
+float blendFactor(float t0, float t1, float time)
+{
+	float const span = t1 - t0;
+	return span > 0.0f ? std::clamp((time - t0) / span, 0.0f, 1.0f) : 0.0f;
+}
+
+// 1 - cos(angle / 2) for the angle between two rotations, in double: near zero angles
+// 2 * acos(|dot|) in float only resolves steps of about 5e-4 rad, too coarse for the error bounds
+double rotationDistance(glm::quat const& a, glm::quat const& b)
+{
+	double const dot = double(a.x) * b.x + double(a.y) * b.y + double(a.z) * b.z + double(a.w) * b.w;
+	double const lengths = std::sqrt((double(a.x) * a.x + double(a.y) * a.y + double(a.z) * a.z + double(a.w) * a.w) *
+																	 (double(b.x) * b.x + double(b.y) * b.y + double(b.z) * b.z + double(b.w) * b.w));
+	return lengths > 0.0 ? 1.0 - std::min(std::abs(dot) / lengths, 1.0) : 1.0;
+}
+
+// Greedy key reduction over `count` keys: extend each segment from the last kept key as far as
+// fits(a, b, k) holds for every key k in between, where fits tests whether key k is reproduced by
+// interpolating kept keys a and b. Returns the kept indices, always including the end keys, or
+// only the first one if it holds the whole channel.
+template <typename Fits>
+std::vector<int> reduceKeys(int count, Fits fits)
+{
+	if (count == 0)
+		return {};
+
+	bool constant = true;
+	for (int k = 1; k < count && constant; k++)
+		constant = fits(0, 0, k);
+	if (constant)
+		return {0};
+
+	std::vector<int> kept{0};
+	int anchor = 0;
+	for (int next = 2; next < count; next++) {
+		bool skippable = true;
+		for (int k = anchor + 1; k < next && skippable; k++)
+			skippable = fits(anchor, next, k);
+		if (!skippable) {
+			anchor = next - 1;
+			kept.push_back(anchor);
+		}
+	}
+	kept.push_back(count - 1);
+	return kept;
+}
+
+// Kept key indices of every channel of one bone
+struct ReducedTrack {
+	std::vector<int> positions;
+	std::vector<int> rotations;
+	std::vector<int> scales;
+};
+
+size_t rawTrackBytes(BoneTrack const& track)
+{
+	return track.positions.size() * sizeof(KeyPosition) + track.rotations.size() * sizeof(KeyRotation) + track.scales.size() * sizeof(KeyScale);
+}
+
+size_t compressedTrackBytes(CompressedTrack const& track)
+{
+	size_t const times = track.positionTimes.size() + track.rotationTimes.size() + track.scaleTimes.size();
+	return times * sizeof(std::uint16_t) + track.positions.size() * sizeof(glm::vec3) + track.rotations.size() * sizeof(PackedQuat) +
+				 track.scales.size() * sizeof(glm::vec3);
+}
+
+// Sample `clip` and propagate it through the flattened hierarchy into model-space node transforms
+void evaluateGlobals(AnimationClip const& clip, Skeleton const& skeleton, float time, PoseSampler& sampler, std::vector<TrackCursor>& cursors,
+										 std::vector<glm::mat4>& globals)
+{
+	sampler.sample(clip, time, cursors, nullptr, &skeleton.restPose);
+	std::vector<glm::mat4> const& locals = sampler.locals();
+
+	for (size_t node = 0; node < skeleton.nodeCount(); node++) {
+		int const bone = skeleton.nodeBones[node];
+		glm::mat4 const& local = bone >= 0 && clip.animates(bone) ? locals[bone] : skeleton.nodeRestTransforms[node];
+		int const parent = skeleton.nodeParents[node];
+		globals[node] = parent >= 0 ? globals[parent] * local : local;
+	}
+}
+} // namespace
+
+ClipCompressionReport compressClip(AnimationClip& clip, Skeleton const& skeleton, AnimationCompressionSettings const& settings)
+{
+	ClipCompressionReport report;
+	report.clip = clip.name;
+
+	if (clip.compressed() || clip.tracks.empty())
+		return report;
+
+	size_t const boneCount = clip.tracks.size();
+	std::vector<ReducedTrack> reduced(boneCount);
+	std::vector<float> rawTimes;
+
+	// rotationDistance() bound equivalent to an angle of settings.rotationError
+	double const rotationTolerance = 1.0 - std::cos(0.5 * double(settings.rotationError));
+	std::vector<float> keptTimes;
+
+	for (size_t bone = 0; bone < boneCount; bone++) {
+		BoneTrack const& track = clip.tracks[bone];
+		ReducedTrack& out = reduced[bone];
+		report.rawKeys += track.positions.size() + track.rotations.size() + track.scales.size();
+		report.rawBytes += rawTrackBytes(track);
+
+		out.positions = reduceKeys(static_cast<int>(track.positions.size()), [&](int a, int b, int k) {
+			float const f = blendFactor(track.positions[a].timeStamp, track.positions[b].timeStamp, track.positions[k].timeStamp);
+			return glm::length(glm::mix(track.positions[a].position, track.positions[b].position, f) - track.positions[k].position) <= settings.translationError;
+		});
+
+		out.scales = reduceKeys(static_cast<int>(track.scales.size()), [&](int a, int b, int k) {
+			float const f = blendFactor(track.scales[a].timeStamp, track.scales[b].timeStamp, track.scales[k].timeStamp);
+			return glm::length(glm::mix(track.scales[a].scale, track.scales[b].scale, f) - track.scales[k].scale) <= settings.scaleError;
+		});
+
+		// Kept rotations are stored quantized, so test the interpolation of the decoded keys
+		std::vector<glm::quat> decoded(track.rotations.size());
+		for (size_t k = 0; k < track.rotations.size(); k++)
+			decoded[k] = PackedQuat::pack(track.rotations[k].orientation).unpack();
+
+		out.rotations = reduceKeys(static_cast<int>(track.rotations.size()), [&](int a, int b, int k) {
+			float const f = blendFactor(track.rotations[a].timeStamp, track.rotations[b].timeStamp, track.rotations[k].timeStamp);
+			return rotationDistance(nlerpShortest(decoded[a], decoded[b], f), track.rotations[k].orientation) <= rotationTolerance;
+		});
+
+		for (KeyPosition const& key : track.positions)
+			rawTimes.push_back(key.timeStamp);
+		for (KeyRotation const& key : track.rotations)
+			rawTimes.push_back(key.timeStamp);
+		for (KeyScale const& key : track.scales)
+			rawTimes.push_back(key.timeStamp);
+
+		for (int k : out.positions)
+			keptTimes.push_back(track.positions[k].timeStamp);
+		for (int k : out.rotations)
+			keptTimes.push_back(track.rotations[k].timeStamp);
+		for (int k : out.scales)
+			keptTimes.push_back(track.scales[k].timeStamp);
+	}
+
+	std::sort(keptTimes.begin(), keptTimes.end());
+	keptTimes.erase(std::unique(keptTimes.begin(), keptTimes.end()), keptTimes.end());
+	if (keptTimes.size() > std::numeric_limits<std::uint16_t>::max() + size_t(1)) {
+		std::cerr << "[AnimationCompression] Clip '" << clip.name << "' has " << keptTimes.size() << " distinct key times, left uncompressed" << std::endl;
+		return report;
+	}
+
+	// Build the compressed clip next to the raw one so both can be sampled for the error report
+	AnimationClip packed;
+	packed.name = clip.name;
+	packed.duration = clip.duration;
+	packed.ticksPerSecond = clip.ticksPerSecond;
+	packed.keyTimes = std::move(keptTimes);
+	packed.compressedTracks.resize(boneCount);
+
+	std::vector<float> const& times = packed.keyTimes;
+	auto timeIndex = [&times](float time) { return static_cast<std::uint16_t>(std::lower_bound(times.begin(), times.end(), time) - times.begin()); };
+
+	for (size_t bone = 0; bone < boneCount; bone++) {
+		BoneTrack const& track = clip.tracks[bone];
+		ReducedTrack const& keep = reduced[bone];
+		CompressedTrack& out = packed.compressedTracks[bone];
+
+		for (int k : keep.positions) {
+			out.positionTimes.push_back(timeIndex(track.positions[k].timeStamp));
+			out.positions.push_back(track.positions[k].position);
+		}
+		for (int k : keep.rotations) {
+			out.rotationTimes.push_back(timeIndex(track.rotations[k].timeStamp));
+			out.rotations.push_back(PackedQuat::pack(track.rotations[k].orientation));
+		}
+		for (int k : keep.scales) {
+			out.scaleTimes.push_back(timeIndex(track.scales[k].timeStamp));
+			out.scales.push_back(track.scales[k].scale);
+		}
+
+		report.keptKeys += out.positions.size() + out.rotations.size() + out.scales.size();
+		report.compressedBytes += compressedTrackBytes(out);
+	}
+	report.compressedBytes += packed.keyTimes.size() * sizeof(float);
+
+	// Joint error in model space, where parent errors accumulate, at every original key time
+	std::sort(rawTimes.begin(), rawTimes.end());
+	rawTimes.erase(std::unique(rawTimes.begin(), rawTimes.end()), rawTimes.end());
+
+	PoseSampler rawSampler, packedSampler;
+	std::vector<TrackCursor> rawCursors(boneCount), packedCursors(boneCount);
+	std::vector<glm::mat4> rawGlobals(skeleton.nodeCount()), packedGlobals(skeleton.nodeCount());
+	for (float time : rawTimes) {
+		evaluateGlobals(clip, skeleton, time, rawSampler, rawCursors, rawGlobals);
+		evaluateGlobals(packed, skeleton, time, packedSampler, packedCursors, packedGlobals);
+		for (size_t node = 0; node < skeleton.nodeCount(); node++) {
+			if (skeleton.nodeBones[node] >= 0)
+				report.maxJointError = std::max(report.maxJointError, glm::length(glm::vec3(rawGlobals[node][3]) - glm::vec3(packedGlobals[node][3])));
+		}
+	}
+
+	clip = std::move(packed);
+	report.compressed = true;
+	return report;
+}
@@ -1,7 +1,34 @@
 #include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
 #include <iostream>
 
 #include "Application.hpp"
+#include "Frustum.hpp"
+#include "GLStateCache.hpp"
+#include "JobSystem.hpp"
+#include "ProgramBinaryCache.hpp"
+#include "TextureCache.hpp"
+
+namespace {
+// Fraction of the screen height covered by the entity's bounding sphere
+float projectedScreenFraction(Entity const& entity, Camera const& camera)
+{
+	if (!entity.model || entity.model->boundingBoxes.empty()) {
+		return 1.0f;
+	}
+
+	BoundingBox const box = transformBoundingBox(entity.model->globalBoundingBox, entity.transform);
+	glm::vec3 const center = (box.min + box.max) * 0.5f;
+	float const radius = glm::length(box.max - box.min) * 0.5f;
+	float const distance = glm::length(center - camera.position());
+	if (distance <= radius) {
+		return 1.0f;
+	}
+
+	// proj[1][1] is 1 / tan(fovY / 2)
+	return radius * camera.proj()[1][1] / distance;
+}
+} // namespace
 
 Application::Application()
 {
@@ -23,6 +50,10 @@ int Application::run()
 	// Enter the main loop
 	mainLoop_();
 
+	ProgramBinaryCache::Stats const& programCache = ProgramBinaryCache::getInstance().stats();
+	std::cout << "[Application] Program binary cache: " << programCache.hits << " hits, " << programCache.misses << " misses, "
+						<< programCache.compileMs << " ms compiling, " << programCache.savedMs << " ms saved" << std::endl;
+
 	cleanup_();
 	return 0;
 }
@@ -147,36 +178,36 @@ void Application::setupDefaultScene_()
 	std::string const path = "assets/models/smo_ina/scene.gltf";
 	std::string const name = "ina";
 
-	// Add a character model
+	// Show a placeholder right away and swap in the model once it finished loading in the background
 	auto& registry = ModelRegistry::getInstance();
+	registry.addModelToSceneCentered(scene_, registry.placeholderModel(), name, glm::vec3(0.0f), glm::vec3(0.0f), 1.0f);
+	scene_.setupCameraToViewEntity(name, 3.0f);
 
-	try {
-		// Load the model
-		Model* model = registry.loadModel(path, name);
+	registry.loadModelAsync(path, name, glm::vec3(0.0f), glm::vec3(0.0f), 1.0f, [this, name](Model* model) {
+		if (!model) {
+			scene_.removeEntity(name);
+			return;
+		}
 
-		if (model) {
-			std::cout << "[Application] Model loaded successfully with " << model->meshes.size() << " meshes" << std::endl;
+		std::cout << "[Application] Model loaded successfully with " << model->meshes.size() << " meshes" << std::endl;
 
-			if (!model->meshes.empty())
-				std::cout << "[Application] First mesh has " << model->meshes[0].vertices.size() << " vertices" << std::endl;
+		if (!model->meshes.empty())
+			std::cout << "[Application] First mesh has " << model->meshes[0].vertices.size() << " vertices" << std::endl;
 
-			// Add to scene with a centered transform at specified position
-			registry.addModelToSceneCentered(scene_, model, name, glm::vec3(0.0f, 0.0f, 0.0f), // position
-																			 glm::vec3(0.0f),																	 // rotation
-																			 1.0f);																						 // scale
+		// Replace the placeholder, centered at the specified position
+		scene_.replaceModel(name, model);
+		if (Entity* entity = scene_.findEntity(name))
+			entity->transform = ModelRegistry::centeredTransform(*model, glm::vec3(0.0f), glm::vec3(0.0f), 1.0f);
 
-			// Position camera to view the model properly
-			scene_.setupCameraToViewEntity(name, 3.0f);
+		// Position camera to view the model properly
+		scene_.setupCameraToViewEntity(name, 3.0f);
 
-			// If model has animations, show animation controls
-			if (model->hasAnimations) {
-				showAnimationControls_ = true;
-				ImGuiManager::getInstance().setAnimationControlsVisible(true);
-			}
+		// If model has animations, show animation controls
+		if (model->hasAnimations) {
+			showAnimationControls_ = true;
+			ImGuiManager::getInstance().setAnimationControlsVisible(true);
 		}
-	} catch (std::runtime_error const& error) {
-		std::cerr << error.what() << std::endl;
-	}
+	});
 }
 
 void Application::processInput_(float dt)
@@ -225,6 +256,9 @@ void Application::mainLoop_()
 		// Poll events before any updates
 		glfwPollEvents();
 
+		// Finish background model loads within this frame's upload budget
+		ModelRegistry::getInstance().update(MODEL_UPLOAD_BUDGET_MS);
+
 		// Process fixed updates
 		while (accumulator >= fixedTimeStep) {
 			tick_(fixedTimeStep);
@@ -248,11 +282,43 @@ void Application::tick_(float dt)
 	// Update camera matrices
 	scene_.cam.updateMatrices(window_);
 
-	// Update animations for all models in the scene
+	// Advance each entity's own animation, shared models are no longer ticked once per reference
+	updateAnimations_(dt);
+}
+
+void Application::updateAnimations_(float dt)
+{
+	animatedEntities_.clear();
 	for (auto& entity : scene_.ents) {
-		if (entity.visible && entity.model && entity.model->hasAnimations) {
-			entity.model->updateAnimation(dt);
+		if (entity.visible && entity.animation.valid()) {
+			animatedEntities_.push_back(&entity);
+		}
+	}
+
+	// Instances only write their own pose and palette (sampler scratch is per thread), so they
+	// update in parallel; the renderer uploads the palettes afterwards on the main thread.
+	// Small characters on screen update less often and skip their leaf bones.
+	std::uint64_t const tick = ++animationTick_;
+	JobSystem::getInstance().parallelFor(animatedEntities_.size(), ANIMATION_JOB_GRAIN, [this, dt, tick](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			Entity& entity = *animatedEntities_[i];
+			entity.animation.setTick(tick);
+			entity.animation.setLod(animationLod_.select(projectedScreenFraction(entity, scene_.cam), entity.animation.getLod()));
+			entity.animation.update(dt);
+		}
+	});
+
+	animationStats_ = AnimationStats();
+	for (Entity const* entity : animatedEntities_) {
+		if (!entity->animation.isPlaying()) {
+			continue;
 		}
+		size_t const bones = entity->model->skeleton.bones.size();
+		size_t const evaluated = entity->animation.evaluatedBones();
+		animationStats_.playing++;
+		animationStats_.posesEvaluated += evaluated > 0 ? 1 : 0;
+		animationStats_.bonesEvaluated += evaluated;
+		animationStats_.bonesSaved += bones - std::min(bones, evaluated);
 	}
 }
 
@@ -279,6 +345,25 @@ void Application::draw_(float interpolation)
 		ImGui::Begin("Statistics");
 		ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
 		ImGui::Text("Scene entities: %zu", scene_.ents.size());
+
+		// Renderer stats from the last frame
+		Renderer::FrameStats const& stats = renderer_.frameStats();
+		ImGui::Text("Draw calls: %d, visible entities: %d", stats.drawCalls, stats.visibleEntities);
+		ImGui::Text("Culled entities: %d, culled meshes: %d", stats.culledEntities, stats.culledMeshes);
+		ImGui::Text("FrameData UBO: %zu bytes, uniform bytes saved: %zu", stats.frameDataBytes, stats.uniformBytesSaved);
+		ImGui::Text("Draw items: %d, program binds: %d, material binds: %d", stats.drawItems, stats.programBinds, stats.materialBinds);
+		ImGui::Text("VAO binds: %d, per-object uniform updates: %d", stats.vaoBinds, stats.objectUniformUpdates);
+		ImGui::Text("Instanced batches: %d, instances drawn: %d", stats.instancedBatches, stats.instancesDrawn);
+		ImGui::Text("Shader variants: %zu", renderer_.shaderVariantCount());
+
+		ProgramBinaryCache::Stats const& programCache = ProgramBinaryCache::getInstance().stats();
+		ImGui::Text("Program binary cache: %d hits, %d misses, %.1f ms saved", programCache.hits, programCache.misses, programCache.savedMs);
+
+		TextureCache::Stats const textureCache = TextureCache::getInstance().stats();
+		ImGui::Text("Textures: %zu cached, %zu reused, %zu uploaded", TextureCache::getInstance().size(), textureCache.hits, textureCache.misses);
+
+		GLStateCache::Counters const& glCalls = GLStateCache::getInstance().frameCounters();
+		ImGui::Text("GL state calls issued: %d, elided: %d", glCalls.issued, glCalls.elided);
 		ImGui::Text("Press TAB to toggle camera mode");
 		ImGui::Text("F1-F3 to toggle UI windows");
 
@@ -293,6 +378,15 @@ void Application::draw_(float interpolation)
 
 		if (hasAnimations) {
 			ImGui::Text("F4 to toggle animation controls");
+			ImGui::Checkbox("Animation LOD", &animationLod_.enabled);
+			ImGui::Text("Animated: %d, poses evaluated: %d", animationStats_.playing, animationStats_.posesEvaluated);
+			ImGui::Text("Bone evaluations: %zu, saved by LOD: %zu", animationStats_.bonesEvaluated, animationStats_.bonesSaved);
+
+			bool preSkinning = renderer_.preSkinning();
+			if (ImGui::Checkbox("GPU pre-skinning (transform feedback)", &preSkinning))
+				renderer_.setPreSkinning(preSkinning);
+			if (preSkinning)
+				ImGui::Text("Pre-skinned meshes: %d, vertices: %zu", stats.preSkinnedMeshes, stats.preSkinnedVertices);
 		}
 
 		ImGui::End();
@@ -309,7 +403,7 @@ void Application::drawScene_()
 {
 	int w, h;
 	glfwGetFramebufferSize(window_, &w, &h);
-	renderer_.beginFrame(w, h, {0.1f, 0.11f, 0.13f});
+	renderer_.beginFrame(w, h, {0.1f, 0.11f, 0.13f}, scene_);
 	renderer_.drawScene(scene_);
 	renderer_.endFrame();
 }
@@ -325,6 +419,12 @@ void Application::cleanup_()
 	// Clean up scene resources
 	scene_.cleanup();
 
+	// Delete textures still referenced, e.g. by models never unloaded
+	TextureCache::getInstance().cleanup();
+
+	// Release renderer GL resources while the context is alive
+	renderer_.cleanup();
+
 	// Clean up GLFW
 	glfwDestroyWindow(window_);
 	glfwTerminate();
@@ -0,0 +1,491 @@
+#include "Benchmark.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "Animation.hpp"
+#include "AnimationCompression.hpp"
+#include "BoundingBox.hpp"
+#include "Frustum.hpp"
+#include "FrustumCuller.hpp"
+#include "JobSystem.hpp"
+#include "Model.hpp"
+#include "PoseSampler.hpp"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+// Run fn `iterations` times and return the average time per run in nanoseconds
+template <typename Fn>
+double timeNs(int iterations, Fn&& fn)
+{
+	auto start = Clock::now();
+	for (int i = 0; i < iterations; i++)
+		fn();
+	auto end = Clock::now();
+	return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+// Keep results observable so the optimizer cannot drop the work
+volatile size_t sink = 0;
+
+// The pre-flattening hierarchy: heap nodes with child pointer lists, evaluated recursively
+struct RecursiveNode {
+	int boneIndex = -1;
+	glm::mat4 transformation{1.0f};
+	std::vector<std::unique_ptr<RecursiveNode>> children;
+};
+
+void evaluateRecursive(RecursiveNode const* node, glm::mat4 const& parentTransform, float time, Skeleton const& skeleton, AnimationClip const& clip,
+											 std::vector<glm::mat4>& palette)
+{
+	glm::mat4 nodeTransform = node->transformation;
+	if (node->boneIndex >= 0 && !clip.tracks[node->boneIndex].empty())
+		nodeTransform = clip.tracks[node->boneIndex].calculateLocalTransform(time);
+
+	glm::mat4 globalTransform = parentTransform * nodeTransform;
+	if (node->boneIndex >= 0)
+		palette[node->boneIndex] = globalTransform * skeleton.bones[node->boneIndex].offsetMatrix;
+
+	for (auto const& child : node->children)
+		evaluateRecursive(child.get(), globalTransform, time, skeleton, clip, palette);
+}
+
+// Synthetic rig: a helper root plus `joints` bones, each parented to one of the few preceding
+// joints (bushy, moderately deep like a humanoid with fingers), with a 1 second, 30 key clip
+void buildRig(size_t joints, Model& model, std::unique_ptr<RecursiveNode>& root)
+{
+	std::mt19937 rng(static_cast<unsigned>(joints));
+	std::uniform_real_distribution<float> offset(-0.2f, 0.2f);
+	std::uniform_real_distribution<float> angle(-0.5f, 0.5f);
+
+	Skeleton& skeleton = model.skeleton;
+	model.hasAnimations = true;
+
+	AnimationClip clip;
+	clip.name = "bench";
+	clip.duration = 1.0f;
+	clip.ticksPerSecond = 1.0f;
+	clip.tracks.resize(joints);
+
+	std::vector<RecursiveNode*> recursiveNodes;
+	root = std::make_unique<RecursiveNode>();
+
+	// Node 0 is the helper root, bone i is node i + 1
+	skeleton.nodeParents.push_back(-1);
+	skeleton.nodeBones.push_back(-1);
+	skeleton.nodeRestTransforms.push_back(glm::mat4(1.0f));
+
+	for (size_t i = 0; i < joints; i++) {
+		Bone bone;
+		bone.name = "joint_" + std::to_string(i);
+		bone.id = static_cast<int>(i);
+		bone.offsetMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(offset(rng), offset(rng), offset(rng)));
+		skeleton.bones.push_back(bone);
+
+		int const parentBone = i == 0 ? -1 : static_cast<int>(std::uniform_int_distribution<size_t>(i > 4 ? i - 4 : 0, i - 1)(rng));
+		glm::mat4 const rest = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.1f, 0.0f));
+		skeleton.nodeParents.push_back(parentBone + 1);
+		skeleton.nodeBones.push_back(static_cast<int>(i));
+		skeleton.nodeRestTransforms.push_back(rest);
+
+		auto node = std::make_unique<RecursiveNode>();
+		node->boneIndex = static_cast<int>(i);
+		node->transformation = rest;
+		recursiveNodes.push_back(node.get());
+		(parentBone < 0 ? root.get() : recursiveNodes[parentBone])->children.push_back(std::move(node));
+
+		BoneTrack& track = clip.tracks[i];
+		for (int key = 0; key < 30; key++) {
+			float const t = key / 29.0f;
+			track.positions.push_back({glm::vec3(offset(rng), 0.1f, offset(rng)), t});
+			track.rotations.push_back({glm::angleAxis(angle(rng), glm::vec3(0.0f, 0.0f, 1.0f)), t});
+			track.scales.push_back({glm::vec3(1.0f), t});
+		}
+	}
+	skeleton.boneCount = static_cast<int>(joints);
+	skeleton.finalize();
+	model.animations.push_back(std::move(clip));
+}
+} // namespace
+
+namespace Benchmark {
+
+int run(std::string const& name)
+{
+	bool const all = name == "all";
+	bool ran = false;
+
+	if (all || name == "culling") {
+		culling();
+		ran = true;
+	}
+
+	if (all || name == "skeleton") {
+		skeleton();
+		ran = true;
+	}
+
+	if (all || name == "keyframes") {
+		keyframes();
+		ran = true;
+	}
+
+	if (all || name == "sampling") {
+		sampling();
+		ran = true;
+	}
+
+	if (all || name == "compression") {
+		compression();
+		ran = true;
+	}
+
+	if (all || name == "animation") {
+		animation();
+		ran = true;
+	}
+
+	if (!ran) {
+		std::cerr << "[Benchmark ERROR] Unknown benchmark '" << name << "' (available: culling, skeleton, keyframes, sampling, compression, animation, all)"
+							<< std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+void culling()
+{
+	std::cout << "[Benchmark] Frustum culling, SoA kernel: " << FrustumCuller::kernelName() << std::endl;
+	std::cout << "[Benchmark]  boxes | naive glm (ns/box) | SoA build (ns/box) | SoA cull (ns/box) | visible naive/SoA" << std::endl;
+
+	glm::mat4 const view = glm::lookAt(glm::vec3(0.0f, 5.0f, 20.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 const proj = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+	Frustum const frustum = Frustum::fromMatrix(proj * view);
+
+	for (size_t count : {size_t(1000), size_t(10000), size_t(100000)}) {
+		// Random unit-ish models scattered around the camera, roughly a third end up visible
+		std::mt19937 rng(5568);
+		std::uniform_real_distribution<float> position(-60.0f, 60.0f);
+		std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+		std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+
+		BoundingBox const localBox{glm::vec3(-0.5f, 0.0f, -0.3f), glm::vec3(0.5f, 1.8f, 0.3f)};
+		std::vector<glm::mat4> transforms(count);
+		for (auto& transform : transforms) {
+			transform = glm::translate(glm::mat4(1.0f), glm::vec3(position(rng), 0.0f, position(rng)));
+			transform = glm::rotate(transform, angle(rng), glm::vec3(0.0f, 1.0f, 0.0f));
+			transform = glm::scale(transform, glm::vec3(scale(rng)));
+		}
+
+		int const iterations = count >= 100000 ? 20 : 200;
+
+		// Naive: transform the 8 corners with glm like Scene::setupCameraToViewScene, then test
+		size_t naiveVisible = 0;
+		double naiveNs = timeNs(iterations, [&] {
+			size_t visible = 0;
+			for (glm::mat4 const& transform : transforms) {
+				glm::vec3 corners[8] = {
+						glm::vec3(localBox.min.x, localBox.min.y, localBox.min.z), glm::vec3(localBox.max.x, localBox.min.y, localBox.min.z),
+						glm::vec3(localBox.min.x, localBox.max.y, localBox.min.z), glm::vec3(localBox.max.x, localBox.max.y, localBox.min.z),
+						glm::vec3(localBox.min.x, localBox.min.y, localBox.max.z), glm::vec3(localBox.max.x, localBox.min.y, localBox.max.z),
+						glm::vec3(localBox.min.x, localBox.max.y, localBox.max.z), glm::vec3(localBox.max.x, localBox.max.y, localBox.max.z)};
+
+				BoundingBox world{glm::vec3(std::numeric_limits<float>::max()), glm::vec3(std::numeric_limits<float>::lowest())};
+				for (auto const& corner : corners) {
+					glm::vec4 p = transform * glm::vec4(corner, 1.0f);
+					glm::vec3 worldPos = glm::vec3(p) / p.w;
+					world.min = glm::min(world.min, worldPos);
+					world.max = glm::max(world.max, worldPos);
+				}
+				visible += frustum.intersects(world) ? 1 : 0;
+			}
+			naiveVisible = visible;
+			sink = sink + visible;
+		});
+
+		// SoA: build world bounds (Arvo transform), then run the batch kernel
+		FrustumCuller culler;
+		double buildNs = timeNs(iterations, [&] {
+			culler.clear();
+			culler.reserve(count);
+			for (glm::mat4 const& transform : transforms)
+				culler.add(transformBoundingBox(localBox, transform));
+		});
+
+		std::vector<std::uint8_t> visibility;
+		size_t soaVisible = 0;
+		double cullNs = timeNs(iterations, [&] {
+			soaVisible = culler.cull(frustum, visibility);
+			sink = sink + soaVisible;
+		});
+
+		double const n = static_cast<double>(count);
+		std::cout << "[Benchmark] " << std::setw(6) << count << " | " << std::setw(18) << std::fixed << std::setprecision(2) << naiveNs / n << " | "
+							<< std::setw(18) << buildNs / n << " | " << std::setw(17) << cullNs / n << " | " << naiveVisible << "/" << soaVisible << std::endl;
+	}
+}
+
+void skeleton()
+{
+	std::cout << "[Benchmark] Skeleton pose evaluation (sample tracks + hierarchy + palette)" << std::endl;
+	std::cout << "[Benchmark] joints | recursive (us/pose) | flattened (us/pose) | speedup | max palette diff" << std::endl;
+
+	for (size_t joints : {size_t(50), size_t(200), size_t(1000)}) {
+		Model model;
+		std::unique_ptr<RecursiveNode> root;
+		buildRig(joints, model, root);
+
+		AnimationInstance instance;
+		instance.initialize(&model);
+		instance.setAnimation(0);
+
+		int const iterations = joints >= 1000 ? 200 : 2000;
+		std::vector<glm::mat4> recursivePalette(joints, glm::mat4(1.0f));
+
+		int frame = 0;
+		double recursiveNs = timeNs(iterations, [&] {
+			float const t = (frame++ % 97) / 97.0f;
+			evaluateRecursive(root.get(), glm::mat4(1.0f), t, model.skeleton, model.animations[0], recursivePalette);
+			sink = sink + static_cast<size_t>(recursivePalette.back()[3][1]);
+		});
+
+		frame = 0;
+		double flatNs = timeNs(iterations, [&] {
+			float const t = (frame++ % 97) / 97.0f;
+			instance.setProgress(t);
+			sink = sink + static_cast<size_t>(instance.palette().back()[3][1]);
+		});
+
+		// Both paths must produce the same pose, up to nlerp vs slerp (the flattened path samples with PoseSampler)
+		float const t = 0.37f;
+		evaluateRecursive(root.get(), glm::mat4(1.0f), t, model.skeleton, model.animations[0], recursivePalette);
+		instance.setProgress(t);
+		float maxDiff = 0.0f;
+		for (size_t bone = 0; bone < joints; bone++)
+			for (int c = 0; c < 4; c++)
+				for (int r = 0; r < 4; r++)
+					maxDiff = std::max(maxDiff, std::abs(recursivePalette[bone][c][r] - instance.palette()[bone][c][r]));
+
+		std::cout << "[Benchmark] " << std::setw(6) << joints << " | " << std::setw(19) << std::fixed << std::setprecision(2) << recursiveNs / 1000.0 << " | "
+							<< std::setw(19) << flatNs / 1000.0 << " | " << std::setw(6) << recursiveNs / flatNs << "x | " << std::scientific << maxDiff << std::defaultfloat
+							<< std::endl;
+	}
+}
+
+void keyframes()
+{
+	std::cout << "[Benchmark] Keyframe lookup, 10 s clip sampled forward at 60 Hz" << std::endl;
+	std::cout << "[Benchmark]  keys | binary search (ns/sample) | cursor (ns/sample) | mismatches" << std::endl;
+
+	for (size_t keyCount : {size_t(32), size_t(300), size_t(3000)}) {
+		std::mt19937 rng(static_cast<unsigned>(keyCount));
+		std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+
+		float const duration = 10.0f;
+		BoneTrack track;
+		for (size_t key = 0; key < keyCount; key++)
+			track.positions.push_back({glm::vec3(value(rng), value(rng), value(rng)), duration * key / (keyCount - 1)});
+
+		size_t const samples = static_cast<size_t>(duration * 60.0f);
+		int const iterations = 200;
+
+		double binaryNs = timeNs(iterations, [&] {
+			float sum = 0.0f;
+			for (size_t i = 0; i < samples; i++)
+				sum += track.interpolatePosition(i / 60.0f).x;
+			sink = sink + static_cast<size_t>(sum);
+		});
+
+		double cursorNs = timeNs(iterations, [&] {
+			int cursor = -1;
+			float sum = 0.0f;
+			for (size_t i = 0; i < samples; i++)
+				sum += track.interpolatePosition(i / 60.0f, cursor).x;
+			sink = sink + static_cast<size_t>(sum);
+		});
+
+		// The cursor must land on the same keys as the search
+		size_t mismatches = 0;
+		int cursor = -1;
+		for (size_t i = 0; i < samples; i++) {
+			float const t = i / 60.0f;
+			if (track.interpolatePosition(t, cursor) != track.interpolatePosition(t))
+				mismatches++;
+		}
+
+		double const n = static_cast<double>(samples);
+		std::cout << "[Benchmark] " << std::setw(5) << keyCount << " | " << std::setw(25) << std::fixed << std::setprecision(2) << binaryNs / n << " | "
+							<< std::setw(18) << cursorNs / n << " | " << mismatches << std::endl;
+	}
+}
+
+void sampling()
+{
+	std::cout << "[Benchmark] Track sampling, batched kernel: " << PoseSampler::kernelName() << std::endl;
+	std::cout << "[Benchmark]  bones | calculateLocalTransform (ns/bone) | PoseSampler (ns/bone) | speedup | max matrix diff (nlerp vs slerp)" << std::endl;
+
+	for (size_t bones : {size_t(64), size_t(256), size_t(1024)}) {
+		Model model;
+		std::unique_ptr<RecursiveNode> root;
+		buildRig(bones, model, root);
+		AnimationClip const& clip = model.animations[0];
+
+		int const iterations = 200;
+		int const framesPerIteration = 60;
+		std::vector<glm::mat4> reference(bones);
+		std::vector<TrackCursor> cursors(bones);
+
+		// Both paths play the clip forward at 60 Hz with cursors, so only the sampling differs
+		double scalarNs = timeNs(iterations, [&] {
+			std::fill(cursors.begin(), cursors.end(), TrackCursor{});
+			for (int frame = 0; frame < framesPerIteration; frame++) {
+				float const t = frame / 60.0f;
+				for (size_t bone = 0; bone < bones; bone++)
+					reference[bone] = clip.tracks[bone].calculateLocalTransform(t, cursors[bone]);
+			}
+			sink = sink + static_cast<size_t>(reference.back()[3][1]);
+		});
+
+		PoseSampler sampler;
+		double batchedNs = timeNs(iterations, [&] {
+			std::fill(cursors.begin(), cursors.end(), TrackCursor{});
+			for (int frame = 0; frame < framesPerIteration; frame++)
+				sampler.sample(clip, frame / 60.0f, cursors);
+			sink = sink + static_cast<size_t>(sampler.locals().back()[3][1]);
+		});
+
+		// nlerp only approximates slerp, report how far apart the results are
+		float maxDiff = 0.0f;
+		for (int frame = 0; frame < framesPerIteration; frame++) {
+			float const t = frame / 60.0f;
+			std::fill(cursors.begin(), cursors.end(), TrackCursor{});
+			sampler.sample(clip, t, cursors);
+			for (size_t bone = 0; bone < bones; bone++) {
+				glm::mat4 const expected = clip.tracks[bone].calculateLocalTransform(t);
+				for (int c = 0; c < 4; c++)
+					for (int r = 0; r < 4; r++)
+						maxDiff = std::max(maxDiff, std::abs(expected[c][r] - sampler.locals()[bone][c][r]));
+			}
+		}
+
+		double const n = static_cast<double>(bones) * framesPerIteration;
+		std::cout << "[Benchmark] " << std::setw(6) << bones << " | " << std::setw(33) << std::fixed << std::setprecision(2) << scalarNs / n << " | "
+							<< std::setw(21) << batchedNs / n << " | " << std::setw(6) << scalarNs / batchedNs << "x | " << std::scientific << maxDiff << std::defaultfloat
+							<< std::endl;
+	}
+}
+
+void compression()
+{
+	std::cout << "[Benchmark] Clip compression, mocap-like 10 s clip at 60 Hz (smooth rotations, static offsets and scales)" << std::endl;
+	std::cout << "[Benchmark]  bones | raw KB | compressed KB | ratio | keys kept | max joint error | raw sample (ns/bone) | "
+						<< "compressed sample (ns/bone)" << std::endl;
+
+	for (size_t bones : {size_t(32), size_t(64), size_t(128)}) {
+		Model model;
+		std::unique_ptr<RecursiveNode> root;
+		buildRig(bones, model, root);
+
+		// Replace the random 30 key clip with dense, smoothly varying keys like a capture would produce
+		std::mt19937 rng(static_cast<unsigned>(bones));
+		std::uniform_real_distribution<float> frequency(0.2f, 2.0f);
+		std::uniform_real_distribution<float> phase(0.0f, 6.28f);
+
+		AnimationClip clip;
+		clip.name = "mocap";
+		clip.duration = 10.0f;
+		clip.ticksPerSecond = 1.0f;
+		clip.tracks.resize(bones);
+		int const keyCount = 601;
+		for (size_t bone = 0; bone < bones; bone++) {
+			BoneTrack& track = clip.tracks[bone];
+			float const f = frequency(rng), p = phase(rng);
+			glm::vec3 const offset(0.0f, 0.1f, 0.0f);
+			for (int key = 0; key < keyCount; key++) {
+				float const t = key / 60.0f;
+				glm::vec3 const axis = glm::normalize(glm::vec3(std::sin(p), 1.0f, std::cos(p)));
+				track.positions.push_back({bone == 0 ? glm::vec3(std::sin(t * f), 0.0f, t * 0.5f) : offset, t});
+				track.rotations.push_back({glm::angleAxis(0.6f * std::sin(t * f + p), axis), t});
+				track.scales.push_back({glm::vec3(1.0f), t});
+			}
+		}
+		AnimationClip raw = clip;
+		ClipCompressionReport const report = compressClip(clip, model.skeleton);
+
+		int const iterations = 50;
+		int const frames = 600;
+		std::vector<TrackCursor> cursors(bones);
+		PoseSampler sampler;
+		auto play = [&](AnimationClip const& c) {
+			return timeNs(iterations, [&] {
+				std::fill(cursors.begin(), cursors.end(), TrackCursor{});
+				for (int frame = 0; frame < frames; frame++)
+					sampler.sample(c, frame / 60.0f, cursors);
+				sink = sink + static_cast<size_t>(sampler.locals().back()[3][1]);
+			});
+		};
+		double const rawNs = play(raw);
+		double const compressedNs = play(clip);
+
+		double const n = static_cast<double>(bones) * frames;
+		std::cout << "[Benchmark] " << std::setw(6) << bones << " | " << std::setw(6) << report.rawBytes / 1024 << " | " << std::setw(13)
+							<< report.compressedBytes / 1024 << " | " << std::setw(4) << std::fixed << std::setprecision(1) << report.ratio() << "x | " << std::setw(4)
+							<< report.keptKeys << "/" << report.rawKeys << " | " << std::setw(15) << std::scientific << std::setprecision(2) << report.maxJointError << " | "
+							<< std::fixed << std::setw(20) << rawNs / n << " | " << std::setw(27) << compressedNs / n << std::defaultfloat << std::endl;
+	}
+}
+
+void animation()
+{
+	unsigned const hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+	std::cout << "[Benchmark] Animation update phase, 64-bone characters, " << hardwareThreads << " hardware threads" << std::endl;
+	std::cout << "[Benchmark] characters | threads | ms/frame | speedup" << std::endl;
+
+	Model model;
+	std::unique_ptr<RecursiveNode> root;
+	buildRig(64, model, root);
+
+	JobSystem& jobs = JobSystem::getInstance();
+	size_t const defaultWorkers = jobs.workerCount();
+
+	for (size_t characters : {size_t(100), size_t(500)}) {
+		std::vector<AnimationInstance> instances(characters);
+		for (size_t i = 0; i < characters; i++) {
+			instances[i].initialize(&model);
+			instances[i].play();
+			instances[i].setProgress(static_cast<float>(i % 17) / 17.0f);
+		}
+
+		double serialNs = 0.0;
+		for (unsigned threads = 1; threads <= hardwareThreads; threads *= 2) {
+			jobs.setWorkerCount(threads - 1);
+			double const ns = timeNs(50, [&] {
+				jobs.parallelFor(instances.size(), 4, [&](size_t begin, size_t end) {
+					for (size_t i = begin; i < end; i++)
+						instances[i].update(1.0f / 60.0f);
+				});
+				sink = sink + static_cast<size_t>(instances.back().palette().back()[3][1]);
+			});
+			if (threads == 1)
+				serialNs = ns;
+
+			std::cout << "[Benchmark] " << std::setw(10) << characters << " | " << std::setw(7) << threads << " | " << std::setw(8) << std::fixed
+								<< std::setprecision(3) << ns / 1e6 << " | " << std::setw(6) << std::setprecision(2) << serialNs / ns << "x" << std::defaultfloat << std::endl;
+		}
+	}
+
+	jobs.setWorkerCount(defaultWorkers);
+}
+
+} // namespace Benchmark
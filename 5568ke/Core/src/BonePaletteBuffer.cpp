@@ -0,0 +1,161 @@
+#include "BonePaletteBuffer.hpp"
+#include "GLStateCache.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+BonePaletteBuffer::~BonePaletteBuffer() { cleanup(); }
+
+void BonePaletteBuffer::init(size_t matricesPerFrame)
+{
+	cleanup();
+
+	// Texels past GL_MAX_TEXTURE_BUFFER_SIZE read as zero, so no segment may reach beyond it
+	GLint maxTexels = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+	maxSegmentCapacity_ = std::max<size_t>(static_cast<size_t>(maxTexels) / (4 * FRAME_SEGMENTS), 1);
+	overflowLogged_ = false;
+
+	segmentCapacity_ = std::clamp<size_t>(matricesPerFrame, 1, maxSegmentCapacity_);
+	segment_ = 0;
+	cursor_ = 0;
+
+	glGenBuffers(1, &buffer_);
+	glBindBuffer(GL_TEXTURE_BUFFER, buffer_);
+	glBufferData(GL_TEXTURE_BUFFER, segmentCapacity_ * FRAME_SEGMENTS * sizeof(glm::mat4), nullptr, GL_STREAM_DRAW);
+
+	// Every matrix is four RGBA32F texels, fetched column by column in the shader
+	glGenTextures(1, &texture_);
+	GLStateCache::getInstance().bindTexture(TEXTURE_SLOT, GL_TEXTURE_BUFFER, texture_);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, buffer_);
+
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void BonePaletteBuffer::beginFrame()
+{
+	segment_ = (segment_ + 1) % FRAME_SEGMENTS;
+	cursor_ = 0;
+
+	// The segment was last written FRAME_SEGMENTS frames ago, normally this never blocks
+	if (GLsync fence = fences_[segment_]) {
+		glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+		glDeleteSync(fence);
+		fences_[segment_] = nullptr;
+	}
+}
+
+void BonePaletteBuffer::endFrame()
+{
+	if (!buffer_ || cursor_ == 0)
+		return;
+
+	if (fences_[segment_])
+		glDeleteSync(fences_[segment_]);
+	fences_[segment_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+int BonePaletteBuffer::upload(glm::mat4 const* matrices, size_t count)
+{
+	if (!buffer_ || !matrices || count == 0)
+		return -1;
+
+	if (cursor_ + count > maxSegmentCapacity_) {
+		if (!overflowLogged_) {
+			std::cerr << "[BonePaletteBuffer] Palettes beyond " << maxSegmentCapacity_ << " matrices per frame exceed GL_MAX_TEXTURE_BUFFER_SIZE, "
+								<< "drawing them in bind pose" << std::endl;
+			overflowLogged_ = true;
+		}
+		return -1;
+	}
+
+	if (cursor_ + count > segmentCapacity_)
+		grow_(std::min(std::max(segmentCapacity_ * 2, cursor_ + count), maxSegmentCapacity_));
+
+	size_t const base = static_cast<size_t>(segment_) * segmentCapacity_ + cursor_;
+	size_t const bytes = count * sizeof(glm::mat4);
+
+	glBindBuffer(GL_TEXTURE_BUFFER, buffer_);
+	void* dst = glMapBufferRange(GL_TEXTURE_BUFFER, base * sizeof(glm::mat4), bytes,
+															 GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	if (!dst) {
+		glBindBuffer(GL_TEXTURE_BUFFER, 0);
+		return -1;
+	}
+	std::memcpy(dst, matrices, bytes);
+	glUnmapBuffer(GL_TEXTURE_BUFFER);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	int const offset = static_cast<int>(cursor_);
+	cursor_ += count;
+	return offset;
+}
+
+void BonePaletteBuffer::bind() const
+{
+	GLStateCache::getInstance().bindTexture(TEXTURE_SLOT, GL_TEXTURE_BUFFER, texture_);
+}
+
+void BonePaletteBuffer::grow_(size_t matricesPerFrame)
+{
+	size_t const oldCapacity = segmentCapacity_;
+	GLuint const oldBuffer = buffer_;
+
+	segmentCapacity_ = matricesPerFrame;
+
+	GLuint newBuffer = 0;
+	glGenBuffers(1, &newBuffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, segmentCapacity_ * FRAME_SEGMENTS * sizeof(glm::mat4), nullptr, GL_STREAM_DRAW);
+
+	// Palettes already written this frame are still referenced by queued draws, keep them. Their
+	// offsets are relative to the segment, so they stay valid at the segment's new start.
+	if (cursor_ > 0) {
+		glBindBuffer(GL_COPY_READ_BUFFER, oldBuffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, static_cast<size_t>(segment_) * oldCapacity * sizeof(glm::mat4),
+												static_cast<size_t>(segment_) * segmentCapacity_ * sizeof(glm::mat4), cursor_ * sizeof(glm::mat4));
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	GLStateCache::getInstance().bindTexture(TEXTURE_SLOT, GL_TEXTURE_BUFFER, texture_);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, newBuffer);
+
+	glDeleteBuffers(1, &oldBuffer);
+	buffer_ = newBuffer;
+
+	// Old fences refer to the deleted storage
+	for (auto& fence : fences_) {
+		if (fence) {
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+	}
+
+	std::cout << "[BonePaletteBuffer] Grew palette buffer to " << segmentCapacity_ << " matrices per frame" << std::endl;
+}
+
+void BonePaletteBuffer::cleanup()
+{
+	for (auto& fence : fences_) {
+		if (fence) {
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+	}
+
+	if (texture_ != 0) {
+		GLStateCache::getInstance().forgetTexture(texture_);
+		glDeleteTextures(1, &texture_);
+		texture_ = 0;
+	}
+
+	if (buffer_ != 0) {
+		glDeleteBuffers(1, &buffer_);
+		buffer_ = 0;
+	}
+
+	segmentCapacity_ = 0;
+	cursor_ = 0;
+}
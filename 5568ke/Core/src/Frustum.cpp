@@ -0,0 +1,60 @@
+#include "Frustum.hpp"
+
+#include <cmath>
+
+Frustum Frustum::fromMatrix(glm::mat4 const& m)
+{
+	// Rows of the matrix (glm is column major)
+	glm::vec4 const row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+	glm::vec4 const row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+	glm::vec4 const row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+	glm::vec4 const row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+	Frustum f;
+	f.planes[Left] = row3 + row0;
+	f.planes[Right] = row3 - row0;
+	f.planes[Bottom] = row3 + row1;
+	f.planes[Top] = row3 - row1;
+	f.planes[Near] = row3 + row2;
+	f.planes[Far] = row3 - row2;
+
+	for (glm::vec4& plane : f.planes) {
+		float len = glm::length(glm::vec3(plane));
+		if (len > 0.0f)
+			plane = plane / len;
+	}
+	return f;
+}
+
+bool Frustum::intersects(BoundingBox const& box) const
+{
+	glm::vec3 const center = (box.min + box.max) * 0.5f;
+	glm::vec3 const extent = (box.max - box.min) * 0.5f;
+
+	for (glm::vec4 const& plane : planes) {
+		// Projected radius of the box onto the plane normal
+		float const radius = extent.x * std::abs(plane.x) + extent.y * std::abs(plane.y) + extent.z * std::abs(plane.z);
+		float const distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+		if (distance + radius < 0.0f)
+			return false;
+	}
+	return true;
+}
+
+BoundingBox transformBoundingBox(BoundingBox const& box, glm::mat4 const& transform)
+{
+	glm::vec3 const center = (box.min + box.max) * 0.5f;
+	glm::vec3 const extent = (box.max - box.min) * 0.5f;
+
+	// Arvo: new extent is |M| * extent, no need to transform all 8 corners
+	glm::vec3 const worldCenter = glm::vec3(transform * glm::vec4(center, 1.0f));
+	glm::vec3 worldExtent;
+	for (int row = 0; row < 3; row++) {
+		worldExtent[row] = std::abs(transform[0][row]) * extent.x + std::abs(transform[1][row]) * extent.y + std::abs(transform[2][row]) * extent.z;
+	}
+
+	BoundingBox result;
+	result.min = worldCenter - worldExtent;
+	result.max = worldCenter + worldExtent;
+	return result;
+}
@@ -0,0 +1,156 @@
+#include "FrustumCuller.hpp"
+
+#include <cmath>
+
+#if defined(__AVX2__)
+#define FRUSTUM_CULLER_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FRUSTUM_CULLER_SSE2
+#include <emmintrin.h>
+#endif
+
+void FrustumCuller::clear()
+{
+	centerX_.clear();
+	centerY_.clear();
+	centerZ_.clear();
+	extentX_.clear();
+	extentY_.clear();
+	extentZ_.clear();
+}
+
+void FrustumCuller::reserve(size_t count)
+{
+	centerX_.reserve(count);
+	centerY_.reserve(count);
+	centerZ_.reserve(count);
+	extentX_.reserve(count);
+	extentY_.reserve(count);
+	extentZ_.reserve(count);
+}
+
+size_t FrustumCuller::add(BoundingBox const& worldBox)
+{
+	glm::vec3 const center = (worldBox.min + worldBox.max) * 0.5f;
+	glm::vec3 const extent = (worldBox.max - worldBox.min) * 0.5f;
+
+	centerX_.push_back(center.x);
+	centerY_.push_back(center.y);
+	centerZ_.push_back(center.z);
+	extentX_.push_back(extent.x);
+	extentY_.push_back(extent.y);
+	extentZ_.push_back(extent.z);
+	return centerX_.size() - 1;
+}
+
+size_t FrustumCuller::cullScalar(Frustum const& frustum, std::uint8_t* visible, size_t begin, size_t end) const
+{
+	size_t visibleCount = 0;
+	for (size_t i = begin; i < end; i++) {
+		bool inside = true;
+		for (glm::vec4 const& p : frustum.planes) {
+			float const distance = p.x * centerX_[i] + p.y * centerY_[i] + p.z * centerZ_[i] + p.w;
+			float const radius = std::abs(p.x) * extentX_[i] + std::abs(p.y) * extentY_[i] + std::abs(p.z) * extentZ_[i];
+			if (distance + radius < 0.0f) {
+				inside = false;
+				break;
+			}
+		}
+		visible[i] = inside ? 1 : 0;
+		visibleCount += inside ? 1 : 0;
+	}
+	return visibleCount;
+}
+
+size_t FrustumCuller::cull(Frustum const& frustum, std::vector<std::uint8_t>& visible) const
+{
+	size_t const count = size();
+	visible.resize(count);
+	if (count == 0)
+		return 0;
+
+	size_t visibleCount = 0;
+	size_t i = 0;
+
+#if defined(FRUSTUM_CULLER_AVX2)
+	__m256 const signMask = _mm256_set1_ps(-0.0f);
+	__m256 const zero = _mm256_setzero_ps();
+
+	for (; i + 8 <= count; i += 8) {
+		__m256 const cx = _mm256_loadu_ps(&centerX_[i]);
+		__m256 const cy = _mm256_loadu_ps(&centerY_[i]);
+		__m256 const cz = _mm256_loadu_ps(&centerZ_[i]);
+		__m256 const ex = _mm256_loadu_ps(&extentX_[i]);
+		__m256 const ey = _mm256_loadu_ps(&extentY_[i]);
+		__m256 const ez = _mm256_loadu_ps(&extentZ_[i]);
+
+		__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		for (glm::vec4 const& p : frustum.planes) {
+			__m256 const nx = _mm256_set1_ps(p.x);
+			__m256 const ny = _mm256_set1_ps(p.y);
+			__m256 const nz = _mm256_set1_ps(p.z);
+
+			// distance + |n| . extent >= 0
+			__m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, cx), _mm256_mul_ps(ny, cy)), _mm256_add_ps(_mm256_mul_ps(nz, cz), _mm256_set1_ps(p.w)));
+			__m256 r = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_andnot_ps(signMask, nx), ex), _mm256_mul_ps(_mm256_andnot_ps(signMask, ny), ey)),
+															 _mm256_mul_ps(_mm256_andnot_ps(signMask, nz), ez));
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(d, r), zero, _CMP_GE_OQ));
+		}
+
+		int const mask = _mm256_movemask_ps(inside);
+		for (int lane = 0; lane < 8; lane++) {
+			std::uint8_t const bit = static_cast<std::uint8_t>((mask >> lane) & 1);
+			visible[i + lane] = bit;
+			visibleCount += bit;
+		}
+	}
+#elif defined(FRUSTUM_CULLER_SSE2)
+	__m128 const signMask = _mm_set1_ps(-0.0f);
+	__m128 const zero = _mm_setzero_ps();
+
+	for (; i + 4 <= count; i += 4) {
+		__m128 const cx = _mm_loadu_ps(&centerX_[i]);
+		__m128 const cy = _mm_loadu_ps(&centerY_[i]);
+		__m128 const cz = _mm_loadu_ps(&centerZ_[i]);
+		__m128 const ex = _mm_loadu_ps(&extentX_[i]);
+		__m128 const ey = _mm_loadu_ps(&extentY_[i]);
+		__m128 const ez = _mm_loadu_ps(&extentZ_[i]);
+
+		__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (glm::vec4 const& p : frustum.planes) {
+			__m128 const nx = _mm_set1_ps(p.x);
+			__m128 const ny = _mm_set1_ps(p.y);
+			__m128 const nz = _mm_set1_ps(p.z);
+
+			// distance + |n| . extent >= 0
+			__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, cx), _mm_mul_ps(ny, cy)), _mm_add_ps(_mm_mul_ps(nz, cz), _mm_set1_ps(p.w)));
+			__m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_andnot_ps(signMask, nx), ex), _mm_mul_ps(_mm_andnot_ps(signMask, ny), ey)),
+														_mm_mul_ps(_mm_andnot_ps(signMask, nz), ez));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(d, r), zero));
+		}
+
+		int const mask = _mm_movemask_ps(inside);
+		for (int lane = 0; lane < 4; lane++) {
+			std::uint8_t const bit = static_cast<std::uint8_t>((mask >> lane) & 1);
+			visible[i + lane] = bit;
+			visibleCount += bit;
+		}
+	}
+#endif
+
+	// Remaining boxes (or everything without SIMD)
+	visibleCount += cullScalar(frustum, visible.data(), i, count);
+	return visibleCount;
+}
+
+char const* FrustumCuller::kernelName()
+{
+#if defined(FRUSTUM_CULLER_AVX2)
+	return "AVX2 (8 boxes)";
+#elif defined(FRUSTUM_CULLER_SSE2)
+	return "SSE2 (4 boxes)";
+#else
+	return "scalar";
+#endif
+}
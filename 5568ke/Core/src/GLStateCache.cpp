@@ -0,0 +1,106 @@
+#include "GLStateCache.hpp"
+
+void GLStateCache::useProgram(GLuint program)
+{
+	if (program_ == program) {
+		counters_.elided++;
+		return;
+	}
+	glUseProgram(program);
+	program_ = program;
+	counters_.issued++;
+}
+
+void GLStateCache::bindVertexArray(GLuint vao)
+{
+	if (vao_ == vao) {
+		counters_.elided++;
+		return;
+	}
+	glBindVertexArray(vao);
+	vao_ = vao;
+	counters_.issued++;
+}
+
+void GLStateCache::bindTexture(unsigned unit, GLenum target, GLuint texture)
+{
+	int slot = target == GL_TEXTURE_2D ? TARGET_2D : target == GL_TEXTURE_BUFFER ? TARGET_BUFFER : -1;
+
+	if (slot >= 0 && unit < MAX_TEXTURE_UNITS && textures_[slot][unit] == texture) {
+		counters_.elided++;
+		return;
+	}
+
+	activeTexture_(unit);
+	glBindTexture(target, texture);
+	counters_.issued++;
+
+	if (slot >= 0 && unit < MAX_TEXTURE_UNITS)
+		textures_[slot][unit] = texture;
+}
+
+void GLStateCache::forgetTexture(GLuint texture)
+{
+	for (auto& units : textures_) {
+		for (GLuint& bound : units) {
+			if (bound == texture)
+				bound = UNKNOWN;
+		}
+	}
+}
+
+void GLStateCache::enable(GLenum cap) { setCapability_(cap, true); }
+
+void GLStateCache::disable(GLenum cap) { setCapability_(cap, false); }
+
+void GLStateCache::cullFace(GLenum mode)
+{
+	if (cullFace_ == mode) {
+		counters_.elided++;
+		return;
+	}
+	glCullFace(mode);
+	cullFace_ = mode;
+	counters_.issued++;
+}
+
+void GLStateCache::invalidate()
+{
+	program_ = UNKNOWN;
+	vao_ = UNKNOWN;
+	activeUnit_ = UNKNOWN;
+	for (auto& units : textures_)
+		units.fill(UNKNOWN);
+	capabilities_.fill(-1);
+	cullFace_ = GL_NONE;
+}
+
+void GLStateCache::activeTexture_(unsigned unit)
+{
+	if (activeUnit_ == unit) {
+		counters_.elided++;
+		return;
+	}
+	glActiveTexture(GL_TEXTURE0 + unit);
+	activeUnit_ = unit;
+	counters_.issued++;
+}
+
+void GLStateCache::setCapability_(GLenum cap, bool enabled)
+{
+	int slot = cap == GL_DEPTH_TEST ? CAP_DEPTH_TEST : cap == GL_CULL_FACE ? CAP_CULL_FACE : cap == GL_BLEND ? CAP_BLEND : -1;
+
+	if (slot >= 0 && capabilities_[slot] == static_cast<int>(enabled)) {
+		counters_.elided++;
+		return;
+	}
+
+	if (enabled)
+		glEnable(cap);
+	else
+		glDisable(cap);
+	counters_.issued++;
+
+	if (slot >= 0)
+		capabilities_[slot] = static_cast<int>(enabled);
+}
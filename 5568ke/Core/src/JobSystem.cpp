@@ -0,0 +1,185 @@
+#include "JobSystem.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+namespace {
+// Index of the worker running on this thread, -1 on threads outside the pool
+thread_local int workerIndex = -1;
+} // namespace
+
+void JobSystem::WorkQueue::push(Job job)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	jobs_.push_back(std::move(job));
+}
+
+bool JobSystem::WorkQueue::pop(Job& job)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (jobs_.empty())
+		return false;
+	job = std::move(jobs_.back());
+	jobs_.pop_back();
+	return true;
+}
+
+bool JobSystem::WorkQueue::steal(Job& job)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (jobs_.empty())
+		return false;
+	job = std::move(jobs_.front());
+	jobs_.pop_front();
+	return true;
+}
+
+bool JobSystem::WorkQueue::popBatch(Job& job, std::atomic<size_t> const* pending)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	for (auto it = jobs_.rbegin(); it != jobs_.rend(); ++it) {
+		if (it->pending == pending) {
+			job = std::move(*it);
+			jobs_.erase(std::next(it).base());
+			return true;
+		}
+	}
+	return false;
+}
+
+JobSystem::JobSystem()
+{
+	unsigned const hardwareThreads = std::thread::hardware_concurrency();
+	start_(hardwareThreads > 1 ? hardwareThreads - 1 : 0);
+}
+
+JobSystem::~JobSystem() { stop_(); }
+
+void JobSystem::setWorkerCount(size_t workers)
+{
+	if (workers == workers_.size())
+		return;
+	stop_();
+	start_(workers);
+}
+
+void JobSystem::start_(size_t workers)
+{
+	queues_.clear();
+	for (size_t i = 0; i < workers + 1; i++)
+		queues_.push_back(std::make_unique<WorkQueue>());
+
+	running_ = true;
+	for (size_t i = 0; i < workers; i++)
+		workers_.emplace_back(&JobSystem::workerLoop_, this, i);
+
+	std::cout << "[JobSystem] Started " << workers << " worker threads" << std::endl;
+}
+
+void JobSystem::stop_()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex_);
+		running_ = false;
+	}
+	wake_.notify_all();
+
+	for (std::thread& worker : workers_)
+		worker.join();
+	workers_.clear();
+}
+
+void JobSystem::parallelFor(size_t count, size_t grain, std::function<void(size_t, size_t)> const& fn)
+{
+	if (count == 0)
+		return;
+
+	grain = std::max<size_t>(grain, 1);
+	if (workers_.empty() || count <= grain) {
+		fn(0, count);
+		return;
+	}
+
+	size_t const self = queueIndex_();
+	size_t const jobCount = (count + grain - 1) / grain;
+	std::atomic<size_t> pending{jobCount};
+
+	// Count first, so a thief never sees more jobs taken than queued
+	queuedJobs_ += jobCount;
+	for (size_t begin = 0; begin < count; begin += grain) {
+		size_t const end = std::min(begin + grain, count);
+		queues_[self]->push(Job{[&fn, begin, end] { fn(begin, end); }, &pending});
+	}
+
+	// Taking the lock orders the count update before any sleeping worker re-checks it
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex_);
+	}
+	wake_.notify_all();
+
+	// Help instead of blocking; this also keeps nested parallelFor calls from deadlocking
+	while (pending.load(std::memory_order_acquire) > 0) {
+		Job job;
+		if (findHelpJob_(self, &pending, job))
+			execute_(job);
+		else
+			std::this_thread::yield();
+	}
+}
+
+void JobSystem::workerLoop_(size_t index)
+{
+	workerIndex = static_cast<int>(index);
+
+	while (true) {
+		Job job;
+		if (findJob_(index, job)) {
+			execute_(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(sleepMutex_);
+		wake_.wait(lock, [this] { return !running_ || queuedJobs_.load() > 0; });
+		if (!running_)
+			return;
+	}
+}
+
+bool JobSystem::findJob_(size_t self, Job& job)
+{
+	if (queues_[self]->pop(job)) {
+		queuedJobs_--;
+		return true;
+	}
+
+	size_t const queueCount = queues_.size();
+	for (size_t offset = 1; offset < queueCount; offset++) {
+		if (queues_[(self + offset) % queueCount]->steal(job)) {
+			queuedJobs_--;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool JobSystem::findHelpJob_(size_t self, std::atomic<size_t> const* pending, Job& job)
+{
+	if (workerIndex >= 0)
+		return findJob_(self, job);
+
+	// The shared deque also holds other callers' jobs (e.g. image decodes of a loader thread);
+	// running those here would stall this caller, the workers pick them up instead
+	if (queues_[self]->popBatch(job, pending)) {
+		queuedJobs_--;
+		return true;
+	}
+	return false;
+}
+
+void JobSystem::execute_(Job& job)
+{
+	job.run();
+	job.pending->fetch_sub(1, std::memory_order_release);
+}
+
+size_t JobSystem::queueIndex_() const { return workerIndex >= 0 ? static_cast<size_t>(workerIndex) : workers_.size(); }
@@ -1,5 +1,6 @@
 #include "include_5568ke.hpp"
 
+#include "GLStateCache.hpp"
 #include "Mesh.hpp"
 
 void Mesh::setup()
@@ -8,7 +9,7 @@ void Mesh::setup()
 	glGenBuffers(1, &vbo_);
 	glGenBuffers(1, &ebo_);
 
-	glBindVertexArray(vao_);
+	GLStateCache::getInstance().bindVertexArray(vao_);
 
 	glBindBuffer(GL_ARRAY_BUFFER, vbo_);
 	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
@@ -16,6 +17,13 @@ void Mesh::setup()
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned), indices.data(), GL_STATIC_DRAW);
 
+	setupVertexAttributes_();
+
+	GLStateCache::getInstance().bindVertexArray(0);
+}
+
+void Mesh::setupVertexAttributes_() const
+{
 	// Position attribute
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
@@ -38,33 +46,128 @@ void Mesh::setup()
 		glEnableVertexAttribArray(4);
 		glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, boneData.weights));
 	}
+}
+
+void Mesh::draw(Shader& shader, MaterialTable const& materials) const
+{
+	// `shader` must be the variant matching this mesh (SKINNED if hasAnimation, see ShaderLibrary)
+	bind();
+
+	Material const* boundMaterial = nullptr;
+	for (auto const& prim : primitives) {
+		// Consecutive primitives often share a material, only rebind on change
+		Material const* material = materialOf(prim, materials);
+		if (material && material != boundMaterial) {
+			material->bind(shader);
+			boundMaterial = material;
+		}
+		drawPrimitive(prim);
+	}
+	GLStateCache::getInstance().bindVertexArray(0);
+}
 
-	glBindVertexArray(0);
+void Mesh::bind() const
+{
+	// The element buffer is part of the VAO state, binding the VAO is enough
+	GLStateCache::getInstance().bindVertexArray(vao_);
+}
+
+void Mesh::drawPrimitive(Primitive const& prim) const
+{
+	glDrawElements(GL_TRIANGLES, prim.indexCount, GL_UNSIGNED_INT, (void*)(prim.indexOffset * sizeof(unsigned)));
 }
 
-void Mesh::draw(Shader& shader) const
+unsigned Mesh::instancedVao() const
 {
-	glBindVertexArray(vao_);
+	if (instancedVao_ != 0)
+		return instancedVao_;
+
+	glGenVertexArrays(1, &instancedVao_);
+	GLStateCache::getInstance().bindVertexArray(instancedVao_);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+	setupVertexAttributes_();
 
-	// Set animation flag in shader
-	shader.setBool("hasAnimation", hasAnimation);
+	// Instance slots only ever exist here, the pointers are set by bindInstanceAttributes
+	for (unsigned attrib = INSTANCE_MATRIX_ATTRIB; attrib < INSTANCE_NORMAL_MATRIX_ATTRIB + 3; attrib++) {
+		glEnableVertexAttribArray(attrib);
+		glVertexAttribDivisor(attrib, 1);
+	}
 
-	for (auto const& prim : primitives) {
-		if (prim.material)
-			prim.material->bind(shader);
-		glDrawElements(GL_TRIANGLES, prim.indexCount, GL_UNSIGNED_INT, (void*)(prim.indexOffset * sizeof(unsigned)));
+	GLStateCache::getInstance().bindVertexArray(0);
+	return instancedVao_;
+}
+
+void Mesh::bindInstanceAttributes(unsigned buffer, size_t byteOffset) const
+{
+	// The pointers are VAO state; GL 3.3 has no base instance, so rebase them per batch
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	for (unsigned column = 0; column < 4; column++) {
+		size_t const offset = byteOffset + offsetof(InstanceData, model) + column * sizeof(glm::vec4);
+		glVertexAttribPointer(INSTANCE_MATRIX_ATTRIB + column, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)offset);
 	}
-	glBindVertexArray(0);
+	for (unsigned column = 0; column < 3; column++) {
+		size_t const offset = byteOffset + offsetof(InstanceData, normalMatrix) + column * sizeof(glm::vec3);
+		glVertexAttribPointer(INSTANCE_NORMAL_MATRIX_ATTRIB + column, 3, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)offset);
+	}
+}
+
+void Mesh::drawPrimitiveInstanced(Primitive const& prim, int instanceCount) const
+{
+	glDrawElementsInstanced(GL_TRIANGLES, prim.indexCount, GL_UNSIGNED_INT, (void*)(prim.indexOffset * sizeof(unsigned)), instanceCount);
+}
+
+unsigned Mesh::skinnedVao(unsigned buffer) const
+{
+	if (skinnedVao_ != 0 && skinnedSource_ == buffer)
+		return skinnedVao_;
+
+	if (skinnedVao_ == 0)
+		glGenVertexArrays(1, &skinnedVao_);
+	skinnedSource_ = buffer;
+
+	GLStateCache::getInstance().bindVertexArray(skinnedVao_);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+
+	// Same attribute slots as setup(), so blinn.vert draws it like any static mesh
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(SkinnedVertex), (void*)offsetof(SkinnedVertex, position));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(SkinnedVertex), (void*)offsetof(SkinnedVertex, normal));
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(SkinnedVertex), (void*)offsetof(SkinnedVertex, texcoord));
+
+	GLStateCache::getInstance().bindVertexArray(0);
+	return skinnedVao_;
+}
+
+void Mesh::drawPrimitiveBaseVertex(Primitive const& prim, int baseVertex) const
+{
+	glDrawElementsBaseVertex(GL_TRIANGLES, prim.indexCount, GL_UNSIGNED_INT, (void*)(prim.indexOffset * sizeof(unsigned)), baseVertex);
 }
 
 void Mesh::cleanup()
 {
 	if (vao_ != 0) {
+		GLStateCache::getInstance().bindVertexArray(0);
 		glDeleteVertexArrays(1, &vao_);
 		vao_ = 0;
 	}
 
+	if (instancedVao_ != 0) {
+		GLStateCache::getInstance().bindVertexArray(0);
+		glDeleteVertexArrays(1, &instancedVao_);
+		instancedVao_ = 0;
+	}
+
+	if (skinnedVao_ != 0) {
+		GLStateCache::getInstance().bindVertexArray(0);
+		glDeleteVertexArrays(1, &skinnedVao_);
+		skinnedVao_ = 0;
+		skinnedSource_ = 0;
+	}
+
 	if (vbo_ != 0) {
 		glDeleteBuffers(1, &vbo_);
 		vbo_ = 0;
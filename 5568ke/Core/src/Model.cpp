@@ -1,31 +1,81 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <limits>
 
+#include "Frustum.hpp"
 #include "Model.hpp"
+#include "RenderQueue.hpp"
+#include "TextureCache.hpp"
+
+static UniformHandle const MODEL_UNIFORM = Shader::uniform("model");
+static UniformHandle const NORMAL_MATRIX_UNIFORM = Shader::uniform("normalMatrix");
 
 Model::~Model() { cleanup(); }
 
 void Model::draw(Shader& shader, glm::mat4 const& modelMatrix) const
 {
-	shader.setMat4("model", modelMatrix);
+	// Bone palettes are uploaded by the renderer (see BonePaletteBuffer)
+	shader.setMat4(MODEL_UNIFORM, modelMatrix);
+	shader.setMat3(NORMAL_MATRIX_UNIFORM, computeNormalMatrix(modelMatrix));
+
+	for (auto const& mesh : meshes)
+		mesh.draw(shader, materials);
+}
+
+namespace {
+bool isEmpty(BoundingBox const& box) { return box.min.x > box.max.x; }
+
+void grow(BoundingBox& box, BoundingBox const& other)
+{
+	box.min = glm::min(box.min, other.min);
+	box.max = glm::max(box.max, other.max);
+}
+} // namespace
 
-	// If model has animations, set bone matrices
-	if (hasAnimations) {
-		for (int i = 0; i < skeleton.boneCount && i < Skeleton::MAX_BONES; i++) {
-			std::string uniformName = "boneMatrices[" + std::to_string(i) + "]";
-			shader.setMat4(uniformName.c_str(), skeleton.finalBoneMatrices[i]);
+void Model::calculateBoneBoundingBoxes()
+{
+	BoundingBox const empty{glm::vec3(std::numeric_limits<float>::max()), glm::vec3(std::numeric_limits<float>::lowest())};
+	boneBoundingBoxes.assign(skeleton.bones.size(), empty);
+	rigidBoundingBox = empty;
+
+	for (Mesh const& mesh : meshes) {
+		for (Vertex const& vertex : mesh.vertices) {
+			BoundingBox const point{vertex.position, vertex.position};
+
+			// Unweighted vertices (and meshes without skin data) are drawn in the bind pose
+			bool weighted = false;
+			if (mesh.hasAnimation) {
+				for (int i = 0; i < 4; i++) {
+					int const bone = vertex.boneData.boneIds[i];
+					if (bone < 0 || vertex.boneData.weights[i] <= 0.0f || bone >= static_cast<int>(boneBoundingBoxes.size()))
+						continue;
+					grow(boneBoundingBoxes[bone], point);
+					weighted = true;
+				}
+			}
+			if (!weighted)
+				grow(rigidBoundingBox, point);
 		}
 	}
-
-	for (auto const& mesh : meshes)
-		mesh.draw(shader);
 }
 
-void Model::updateAnimation(float dt)
+BoundingBox Model::poseBoundingBox(std::vector<glm::mat4> const& palette) const
 {
-	if (hasAnimations) {
-		animationPlayer.update(dt);
+	if (boneBoundingBoxes.empty() || palette.size() < boneBoundingBoxes.size())
+		return globalBoundingBox;
+
+	BoundingBox result = rigidBoundingBox;
+	for (size_t bone = 0; bone < boneBoundingBoxes.size(); bone++) {
+		if (isEmpty(boneBoundingBoxes[bone]))
+			continue;
+
+		BoundingBox const moved = transformBoundingBox(boneBoundingBoxes[bone], palette[bone]);
+		if (isEmpty(result))
+			result = moved;
+		else
+			grow(result, moved);
 	}
+	return isEmpty(result) ? globalBoundingBox : result;
 }
 
 glm::mat4 Model::calculateCenteredTransform(float scale) const
@@ -95,8 +145,14 @@ void Model::cleanup()
 	}
 	meshes.clear();
 	boundingBoxes.clear();
+	boneBoundingBoxes.clear();
+	materials.clear();
+
+	// Shared textures are deleted once no model references them
+	for (Texture* texture : textures)
+		TextureCache::getInstance().release(texture);
+	textures.clear();
 
 	// Clean up animations
 	animations.clear();
-	skeleton.finalBoneMatrices.clear();
 }
\ No newline at end of file
@@ -0,0 +1,439 @@
+#include "PoseSampler.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX2__)
+#define POSE_SAMPLER_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define POSE_SAMPLER_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+// Blend factor between keys at t0 and t1, clamped so times outside the track hold the end keys
+float blendFactor(float t0, float t1, float time)
+{
+	float const span = t1 - t0;
+	return span > 0.0f ? std::clamp((time - t0) / span, 0.0f, 1.0f) : 0.0f;
+}
+
+// [R * diag(S) | T] from a unit quaternion, no intermediate 4x4 products
+glm::mat4 composeAffine(glm::vec3 const& p, glm::quat const& q, glm::vec3 const& s)
+{
+	float const x = q.x, y = q.y, z = q.z, w = q.w;
+	glm::mat4 m;
+	m[0] = glm::vec4((1.0f - 2.0f * (y * y + z * z)) * s.x, 2.0f * (x * y + w * z) * s.x, 2.0f * (x * z - w * y) * s.x, 0.0f);
+	m[1] = glm::vec4(2.0f * (x * y - w * z) * s.y, (1.0f - 2.0f * (x * x + z * z)) * s.y, 2.0f * (y * z + w * x) * s.y, 0.0f);
+	m[2] = glm::vec4(2.0f * (x * z + w * y) * s.z, 2.0f * (y * z - w * x) * s.z, (1.0f - 2.0f * (x * x + y * y)) * s.z, 0.0f);
+	m[3] = glm::vec4(p, 1.0f);
+	return m;
+}
+
+#if defined(POSE_SAMPLER_AVX2) || defined(POSE_SAMPLER_SSE2)
+// Write one column of four consecutive matrices from SoA lanes
+inline void storeColumn4(__m128 x, __m128 y, __m128 z, __m128 w, glm::mat4* out, int column)
+{
+	_MM_TRANSPOSE4_PS(x, y, z, w);
+	_mm_storeu_ps(&out[0][column].x, x);
+	_mm_storeu_ps(&out[1][column].x, y);
+	_mm_storeu_ps(&out[2][column].x, z);
+	_mm_storeu_ps(&out[3][column].x, w);
+}
+#endif
+} // namespace
+
+void PoseSampler::sample(AnimationClip const& clip, float time, std::vector<TrackCursor>& cursors, std::vector<std::uint8_t> const* activeBones,
+												 Pose const* rest)
+{
+	size_t const count = clip.boneCount();
+	if (count > capacity_) {
+		capacity_ = count;
+		streams_.resize(capacity_ * STREAM_COUNT);
+	}
+	locals_.resize(count, glm::mat4(1.0f));
+	cursors.resize(count);
+
+	gather_(clip, time, cursors, activeBones, rest);
+
+	float const* tx0 = stream_(TX0);
+	float const* ty0 = stream_(TY0);
+	float const* tz0 = stream_(TZ0);
+	float const* tx1 = stream_(TX1);
+	float const* ty1 = stream_(TY1);
+	float const* tz1 = stream_(TZ1);
+	float const* tf = stream_(TF);
+	float const* sx0 = stream_(SX0);
+	float const* sy0 = stream_(SY0);
+	float const* sz0 = stream_(SZ0);
+	float const* sx1 = stream_(SX1);
+	float const* sy1 = stream_(SY1);
+	float const* sz1 = stream_(SZ1);
+	float const* sf = stream_(SF);
+	float const* qx0 = stream_(QX0);
+	float const* qy0 = stream_(QY0);
+	float const* qz0 = stream_(QZ0);
+	float const* qw0 = stream_(QW0);
+	float const* qx1 = stream_(QX1);
+	float const* qy1 = stream_(QY1);
+	float const* qz1 = stream_(QZ1);
+	float const* qw1 = stream_(QW1);
+	float const* qf = stream_(QF);
+
+	size_t i = 0;
+
+#if defined(POSE_SAMPLER_AVX2)
+	__m256 const one = _mm256_set1_ps(1.0f);
+	__m256 const two = _mm256_set1_ps(2.0f);
+	__m256 const signMask = _mm256_set1_ps(-0.0f);
+
+	for (; i + 8 <= count; i += 8) {
+		// Translation and scale: lerp
+		__m256 f = _mm256_loadu_ps(tf + i);
+		__m256 a = _mm256_loadu_ps(tx0 + i);
+		__m256 const px = _mm256_add_ps(a, _mm256_mul_ps(f, _mm256_sub_ps(_mm256_loadu_ps(tx1 + i), a)));
+		a = _mm256_loadu_ps(ty0 + i);
+		__m256 const py = _mm256_add_ps(a, _mm256_mul_ps(f, _mm256_sub_ps(_mm256_loadu_ps(ty1 + i), a)));
+		a = _mm256_loadu_ps(tz0 + i);
+		__m256 const pz = _mm256_add_ps(a, _mm256_mul_ps(f, _mm256_sub_ps(_mm256_loadu_ps(tz1 + i), a)));
+
+		f = _mm256_loadu_ps(sf + i);
+		a = _mm256_loadu_ps(sx0 + i);
+		__m256 const sx = _mm256_add_ps(a, _mm256_mul_ps(f, _mm256_sub_ps(_mm256_loadu_ps(sx1 + i), a)));
+		a = _mm256_loadu_ps(sy0 + i);
+		__m256 const sy = _mm256_add_ps(a, _mm256_mul_ps(f, _mm256_sub_ps(_mm256_loadu_ps(sy1 + i), a)));
+		a = _mm256_loadu_ps(sz0 + i);
+		__m256 const sz = _mm256_add_ps(a, _mm256_mul_ps(f, _mm256_sub_ps(_mm256_loadu_ps(sz1 + i), a)));
+
+		// Rotation: nlerp, flipping q1 onto q0's hemisphere so the blend takes the short way
+		__m256 const ax = _mm256_loadu_ps(qx0 + i);
+		__m256 const ay = _mm256_loadu_ps(qy0 + i);
+		__m256 const az = _mm256_loadu_ps(qz0 + i);
+		__m256 const aw = _mm256_loadu_ps(qw0 + i);
+		__m256 bx = _mm256_loadu_ps(qx1 + i);
+		__m256 by = _mm256_loadu_ps(qy1 + i);
+		__m256 bz = _mm256_loadu_ps(qz1 + i);
+		__m256 bw = _mm256_loadu_ps(qw1 + i);
+
+		__m256 const dot = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax, bx), _mm256_mul_ps(ay, by)), _mm256_add_ps(_mm256_mul_ps(az, bz), _mm256_mul_ps(aw, bw)));
+		__m256 const sign = _mm256_and_ps(dot, signMask);
+		bx = _mm256_xor_ps(bx, sign);
+		by = _mm256_xor_ps(by, sign);
+		bz = _mm256_xor_ps(bz, sign);
+		bw = _mm256_xor_ps(bw, sign);
+
+		f = _mm256_loadu_ps(qf + i);
+		__m256 x = _mm256_add_ps(ax, _mm256_mul_ps(f, _mm256_sub_ps(bx, ax)));
+		__m256 y = _mm256_add_ps(ay, _mm256_mul_ps(f, _mm256_sub_ps(by, ay)));
+		__m256 z = _mm256_add_ps(az, _mm256_mul_ps(f, _mm256_sub_ps(bz, az)));
+		__m256 w = _mm256_add_ps(aw, _mm256_mul_ps(f, _mm256_sub_ps(bw, aw)));
+
+		__m256 const lengthXY = _mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y));
+		__m256 const lengthZW = _mm256_add_ps(_mm256_mul_ps(z, z), _mm256_mul_ps(w, w));
+		__m256 const length = _mm256_sqrt_ps(_mm256_add_ps(lengthXY, lengthZW));
+		__m256 const invLength = _mm256_div_ps(one, length);
+		x = _mm256_mul_ps(x, invLength);
+		y = _mm256_mul_ps(y, invLength);
+		z = _mm256_mul_ps(z, invLength);
+		w = _mm256_mul_ps(w, invLength);
+
+		// Compose [R * diag(S) | T] directly, no intermediate 4x4 products
+		__m256 const xx = _mm256_mul_ps(x, x), yy = _mm256_mul_ps(y, y), zz = _mm256_mul_ps(z, z);
+		__m256 const xy = _mm256_mul_ps(x, y), xz = _mm256_mul_ps(x, z), yz = _mm256_mul_ps(y, z);
+		__m256 const wx = _mm256_mul_ps(w, x), wy = _mm256_mul_ps(w, y), wz = _mm256_mul_ps(w, z);
+
+		__m256 const c0x = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(yy, zz))), sx);
+		__m256 const c0y = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xy, wz)), sx);
+		__m256 const c0z = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xz, wy)), sx);
+		__m256 const c1x = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xy, wz)), sy);
+		__m256 const c1y = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, zz))), sy);
+		__m256 const c1z = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(yz, wx)), sy);
+		__m256 const c2x = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xz, wy)), sz);
+		__m256 const c2y = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(yz, wx)), sz);
+		__m256 const c2z = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, yy))), sz);
+
+		__m128 const zero4 = _mm_setzero_ps();
+		__m128 const one4 = _mm_set1_ps(1.0f);
+		for (int half = 0; half < 2; half++) {
+			glm::mat4* out = &locals_[i + half * 4];
+			auto lane = [half](__m256 v) { return half == 0 ? _mm256_castps256_ps128(v) : _mm256_extractf128_ps(v, 1); };
+			storeColumn4(lane(c0x), lane(c0y), lane(c0z), zero4, out, 0);
+			storeColumn4(lane(c1x), lane(c1y), lane(c1z), zero4, out, 1);
+			storeColumn4(lane(c2x), lane(c2y), lane(c2z), zero4, out, 2);
+			storeColumn4(lane(px), lane(py), lane(pz), one4, out, 3);
+		}
+	}
+#elif defined(POSE_SAMPLER_SSE2)
+	__m128 const one = _mm_set1_ps(1.0f);
+	__m128 const two = _mm_set1_ps(2.0f);
+	__m128 const zero = _mm_setzero_ps();
+	__m128 const signMask = _mm_set1_ps(-0.0f);
+
+	for (; i + 4 <= count; i += 4) {
+		// Translation and scale: lerp
+		__m128 f = _mm_loadu_ps(tf + i);
+		__m128 a = _mm_loadu_ps(tx0 + i);
+		__m128 const px = _mm_add_ps(a, _mm_mul_ps(f, _mm_sub_ps(_mm_loadu_ps(tx1 + i), a)));
+		a = _mm_loadu_ps(ty0 + i);
+		__m128 const py = _mm_add_ps(a, _mm_mul_ps(f, _mm_sub_ps(_mm_loadu_ps(ty1 + i), a)));
+		a = _mm_loadu_ps(tz0 + i);
+		__m128 const pz = _mm_add_ps(a, _mm_mul_ps(f, _mm_sub_ps(_mm_loadu_ps(tz1 + i), a)));
+
+		f = _mm_loadu_ps(sf + i);
+		a = _mm_loadu_ps(sx0 + i);
+		__m128 const sx = _mm_add_ps(a, _mm_mul_ps(f, _mm_sub_ps(_mm_loadu_ps(sx1 + i), a)));
+		a = _mm_loadu_ps(sy0 + i);
+		__m128 const sy = _mm_add_ps(a, _mm_mul_ps(f, _mm_sub_ps(_mm_loadu_ps(sy1 + i), a)));
+		a = _mm_loadu_ps(sz0 + i);
+		__m128 const sz = _mm_add_ps(a, _mm_mul_ps(f, _mm_sub_ps(_mm_loadu_ps(sz1 + i), a)));
+
+		// Rotation: nlerp, flipping q1 onto q0's hemisphere so the blend takes the short way
+		__m128 const ax = _mm_loadu_ps(qx0 + i);
+		__m128 const ay = _mm_loadu_ps(qy0 + i);
+		__m128 const az = _mm_loadu_ps(qz0 + i);
+		__m128 const aw = _mm_loadu_ps(qw0 + i);
+		__m128 bx = _mm_loadu_ps(qx1 + i);
+		__m128 by = _mm_loadu_ps(qy1 + i);
+		__m128 bz = _mm_loadu_ps(qz1 + i);
+		__m128 bw = _mm_loadu_ps(qw1 + i);
+
+		__m128 const dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_add_ps(_mm_mul_ps(az, bz), _mm_mul_ps(aw, bw)));
+		__m128 const sign = _mm_and_ps(dot, signMask);
+		bx = _mm_xor_ps(bx, sign);
+		by = _mm_xor_ps(by, sign);
+		bz = _mm_xor_ps(bz, sign);
+		bw = _mm_xor_ps(bw, sign);
+
+		f = _mm_loadu_ps(qf + i);
+		__m128 x = _mm_add_ps(ax, _mm_mul_ps(f, _mm_sub_ps(bx, ax)));
+		__m128 y = _mm_add_ps(ay, _mm_mul_ps(f, _mm_sub_ps(by, ay)));
+		__m128 z = _mm_add_ps(az, _mm_mul_ps(f, _mm_sub_ps(bz, az)));
+		__m128 w = _mm_add_ps(aw, _mm_mul_ps(f, _mm_sub_ps(bw, aw)));
+
+		__m128 const length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_add_ps(_mm_mul_ps(z, z), _mm_mul_ps(w, w))));
+		__m128 const invLength = _mm_div_ps(one, length);
+		x = _mm_mul_ps(x, invLength);
+		y = _mm_mul_ps(y, invLength);
+		z = _mm_mul_ps(z, invLength);
+		w = _mm_mul_ps(w, invLength);
+
+		// Compose [R * diag(S) | T] directly, no intermediate 4x4 products
+		__m128 const xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+		__m128 const xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+		__m128 const wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+
+		glm::mat4* out = &locals_[i];
+		storeColumn4(_mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx), _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx),
+								 _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx), zero, out, 0);
+		storeColumn4(_mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy), _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy),
+								 _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy), zero, out, 1);
+		storeColumn4(_mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz), _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz),
+								 _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz), zero, out, 2);
+		storeColumn4(px, py, pz, one, out, 3);
+	}
+#endif
+
+	// Remaining bones (or everything without SIMD)
+	composeScalar_(i, count);
+}
+
+void PoseSampler::gather_(AnimationClip const& clip, float time, std::vector<TrackCursor>& cursors, std::vector<std::uint8_t> const* activeBones,
+											Pose const* rest)
+{
+	float* tx0 = stream_(TX0);
+	float* ty0 = stream_(TY0);
+	float* tz0 = stream_(TZ0);
+	float* tx1 = stream_(TX1);
+	float* ty1 = stream_(TY1);
+	float* tz1 = stream_(TZ1);
+	float* tf = stream_(TF);
+	float* sx0 = stream_(SX0);
+	float* sy0 = stream_(SY0);
+	float* sz0 = stream_(SZ0);
+	float* sx1 = stream_(SX1);
+	float* sy1 = stream_(SY1);
+	float* sz1 = stream_(SZ1);
+	float* sf = stream_(SF);
+	float* qx0 = stream_(QX0);
+	float* qy0 = stream_(QY0);
+	float* qz0 = stream_(QZ0);
+	float* qw0 = stream_(QW0);
+	float* qx1 = stream_(QX1);
+	float* qy1 = stream_(QY1);
+	float* qz1 = stream_(QZ1);
+	float* qw1 = stream_(QW1);
+	float* qf = stream_(QF);
+
+	size_t const count = clip.boneCount();
+	for (size_t bone = 0; bone < count; bone++) {
+		TrackCursor& cursor = cursors[bone];
+
+		// Missing channels hold the rest values when given, the identity otherwise
+		glm::vec3 p0(0.0f), p1(0.0f), s0(1.0f), s1(1.0f);
+		glm::quat q0(1.0f, 0.0f, 0.0f, 0.0f), q1(1.0f, 0.0f, 0.0f, 0.0f);
+		float pf = 0.0f, scaleF = 0.0f, rf = 0.0f;
+		if (rest && bone < rest->size()) {
+			p0 = p1 = rest->translations[bone];
+			s0 = s1 = rest->scales[bone];
+			q0 = q1 = rest->rotations[bone];
+		}
+
+		if (activeBones && !(*activeBones)[bone]) {
+			// Skipped by the LOD: left as identity, the caller uses the rest transform
+		}
+		else if (clip.compressed()) {
+			// Decompress only the bracketing keys; their times come from the shared array
+			CompressedTrack const& track = clip.compressedTracks[bone];
+			std::vector<float> const& times = clip.keyTimes;
+
+			int k0 = track.positionKey(times, time, cursor.position);
+			if (k0 >= 0) {
+				int const k1 = std::min(k0 + 1, static_cast<int>(track.positions.size()) - 1);
+				p0 = track.positions[k0];
+				p1 = track.positions[k1];
+				pf = blendFactor(times[track.positionTimes[k0]], times[track.positionTimes[k1]], time);
+			}
+
+			k0 = track.scaleKey(times, time, cursor.scale);
+			if (k0 >= 0) {
+				int const k1 = std::min(k0 + 1, static_cast<int>(track.scales.size()) - 1);
+				s0 = track.scales[k0];
+				s1 = track.scales[k1];
+				scaleF = blendFactor(times[track.scaleTimes[k0]], times[track.scaleTimes[k1]], time);
+			}
+
+			k0 = track.rotationKey(times, time, cursor.rotation);
+			if (k0 >= 0) {
+				int const k1 = std::min(k0 + 1, static_cast<int>(track.rotations.size()) - 1);
+				q0 = track.rotations[k0].unpack();
+				q1 = track.rotations[k1].unpack();
+				rf = blendFactor(times[track.rotationTimes[k0]], times[track.rotationTimes[k1]], time);
+			}
+		}
+		else {
+			BoneTrack const& track = clip.tracks[bone];
+
+			int k0 = track.positionKey(time, cursor.position);
+			if (k0 >= 0) {
+				int const k1 = std::min(k0 + 1, static_cast<int>(track.positions.size()) - 1);
+				p0 = track.positions[k0].position;
+				p1 = track.positions[k1].position;
+				pf = blendFactor(track.positions[k0].timeStamp, track.positions[k1].timeStamp, time);
+			}
+
+			k0 = track.scaleKey(time, cursor.scale);
+			if (k0 >= 0) {
+				int const k1 = std::min(k0 + 1, static_cast<int>(track.scales.size()) - 1);
+				s0 = track.scales[k0].scale;
+				s1 = track.scales[k1].scale;
+				scaleF = blendFactor(track.scales[k0].timeStamp, track.scales[k1].timeStamp, time);
+			}
+
+			k0 = track.rotationKey(time, cursor.rotation);
+			if (k0 >= 0) {
+				int const k1 = std::min(k0 + 1, static_cast<int>(track.rotations.size()) - 1);
+				q0 = track.rotations[k0].orientation;
+				q1 = track.rotations[k1].orientation;
+				rf = blendFactor(track.rotations[k0].timeStamp, track.rotations[k1].timeStamp, time);
+			}
+		}
+
+		tx0[bone] = p0.x;
+		ty0[bone] = p0.y;
+		tz0[bone] = p0.z;
+		tx1[bone] = p1.x;
+		ty1[bone] = p1.y;
+		tz1[bone] = p1.z;
+		tf[bone] = pf;
+		sx0[bone] = s0.x;
+		sy0[bone] = s0.y;
+		sz0[bone] = s0.z;
+		sx1[bone] = s1.x;
+		sy1[bone] = s1.y;
+		sz1[bone] = s1.z;
+		sf[bone] = scaleF;
+		qx0[bone] = q0.x;
+		qy0[bone] = q0.y;
+		qz0[bone] = q0.z;
+		qw0[bone] = q0.w;
+		qx1[bone] = q1.x;
+		qy1[bone] = q1.y;
+		qz1[bone] = q1.z;
+		qw1[bone] = q1.w;
+		qf[bone] = rf;
+	}
+}
+
+void PoseSampler::composeScalar_(size_t begin, size_t end)
+{
+	for (size_t i = begin; i < end; i++)
+		locals_[i] = composeAffine(translation_(i), rotation_(i), scale_(i));
+}
+
+void PoseSampler::samplePose(AnimationClip const& clip, float time, std::vector<TrackCursor>& cursors, Pose const& rest, Pose& out,
+														 std::vector<std::uint8_t> const* activeBones)
+{
+	size_t const count = clip.boneCount();
+	if (count > capacity_) {
+		capacity_ = count;
+		streams_.resize(capacity_ * STREAM_COUNT);
+	}
+	cursors.resize(count);
+	out.resize(count);
+
+	gather_(clip, time, cursors, activeBones, &rest);
+
+	for (size_t i = 0; i < count; i++) {
+		bool const skipped = !clip.animates(i) || (activeBones && !(*activeBones)[i]);
+		if (skipped && i < rest.size()) {
+			out.translations[i] = rest.translations[i];
+			out.rotations[i] = rest.rotations[i];
+			out.scales[i] = rest.scales[i];
+			continue;
+		}
+		out.translations[i] = translation_(i);
+		out.rotations[i] = rotation_(i);
+		out.scales[i] = scale_(i);
+	}
+}
+
+void PoseSampler::compose(Pose const& pose)
+{
+	size_t const count = pose.size();
+	locals_.resize(count);
+	for (size_t i = 0; i < count; i++)
+		locals_[i] = composeAffine(pose.translations[i], pose.rotations[i], pose.scales[i]);
+}
+
+glm::vec3 PoseSampler::translation_(size_t i)
+{
+	float const f = stream_(TF)[i];
+	auto lerp = [this, i, f](Stream a, Stream b) { return stream_(a)[i] + f * (stream_(b)[i] - stream_(a)[i]); };
+	return glm::vec3(lerp(TX0, TX1), lerp(TY0, TY1), lerp(TZ0, TZ1));
+}
+
+glm::vec3 PoseSampler::scale_(size_t i)
+{
+	float const f = stream_(SF)[i];
+	auto lerp = [this, i, f](Stream a, Stream b) { return stream_(a)[i] + f * (stream_(b)[i] - stream_(a)[i]); };
+	return glm::vec3(lerp(SX0, SX1), lerp(SY0, SY1), lerp(SZ0, SZ1));
+}
+
+glm::quat PoseSampler::rotation_(size_t i)
+{
+	glm::quat const a(stream_(QW0)[i], stream_(QX0)[i], stream_(QY0)[i], stream_(QZ0)[i]);
+	glm::quat const b(stream_(QW1)[i], stream_(QX1)[i], stream_(QY1)[i], stream_(QZ1)[i]);
+	return nlerpShortest(a, b, stream_(QF)[i]);
+}
+
+char const* PoseSampler::kernelName()
+{
+#if defined(POSE_SAMPLER_AVX2)
+	return "AVX2 (8 bones)";
+#elif defined(POSE_SAMPLER_SSE2)
+	return "SSE2 (4 bones)";
+#else
+	return "scalar";
+#endif
+}
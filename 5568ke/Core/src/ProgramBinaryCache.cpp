@@ -0,0 +1,163 @@
+#include "ProgramBinaryCache.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace {
+std::uint32_t const FILE_MAGIC = 0x31434250; // "PBC1"
+
+struct FileHeader {
+	std::uint32_t magic = FILE_MAGIC;
+	std::uint32_t format = 0; // driver-specific binary format
+	std::uint64_t key = 0;
+	std::uint32_t length = 0;
+	float compileMs = 0.0f; // what building from source cost when the entry was written
+};
+
+// FNV-1a 64, each string terminated so {"ab", "c"} and {"a", "bc"} differ
+void hashString(std::uint64_t& hash, std::string const& text)
+{
+	for (char c : text) {
+		hash ^= static_cast<unsigned char>(c);
+		hash *= 1099511628211ull;
+	}
+	hash ^= 0xFFu;
+	hash *= 1099511628211ull;
+}
+
+std::string glString(GLenum name)
+{
+	GLubyte const* value = glGetString(name);
+	return value ? reinterpret_cast<char const*>(value) : "";
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+} // namespace
+
+bool ProgramBinaryCache::supported_()
+{
+	if (supportState_ < 0) {
+		GLint formats = 0;
+		if (glGetProgramBinary && glProgramBinary && glProgramParameteri)
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+		supportState_ = formats > 0 ? 1 : 0;
+		driver_ = glString(GL_VENDOR) + '\n' + glString(GL_RENDERER) + '\n' + glString(GL_VERSION);
+
+		if (!supportState_)
+			std::cout << "[ProgramBinaryCache] Program binaries are not supported by this driver, shaders compile from source" << std::endl;
+	}
+	return supportState_ == 1;
+}
+
+std::uint64_t ProgramBinaryCache::key(std::vector<std::string> const& sources, std::vector<std::string> const& varyings)
+{
+	supported_();
+
+	std::uint64_t hash = 14695981039346656037ull;
+	hashString(hash, driver_);
+	for (std::string const& source : sources)
+		hashString(hash, source);
+	for (std::string const& varying : varyings)
+		hashString(hash, varying);
+	return hash;
+}
+
+std::string ProgramBinaryCache::path_(std::uint64_t key) const
+{
+	char name[32];
+	std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+	return (std::filesystem::path(directory_) / name).string();
+}
+
+bool ProgramBinaryCache::load(std::uint64_t key, GLuint program)
+{
+	if (!enabled_ || !supported_()) {
+		stats_.misses++;
+		return false;
+	}
+
+	auto const start = std::chrono::steady_clock::now();
+	std::ifstream file(path_(key), std::ios::binary);
+	FileHeader header;
+	if (file)
+		file.read(reinterpret_cast<char*>(&header), sizeof(header));
+	if (!file || header.magic != FILE_MAGIC || header.key != key || header.length == 0) {
+		stats_.misses++;
+		return false;
+	}
+
+	std::vector<char> binary(header.length);
+	file.read(binary.data(), header.length);
+	if (!file) {
+		stats_.misses++;
+		return false;
+	}
+
+	glProgramBinary(program, header.format, binary.data(), static_cast<GLsizei>(header.length));
+
+	// Drivers may reject binaries even with an unchanged version string; the program is then
+	// simply unlinked and gets built from source
+	GLint linked = 0;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	if (!linked) {
+		std::cout << "[ProgramBinaryCache] Driver rejected " << path_(key) << ", rebuilding from source" << std::endl;
+		std::error_code error;
+		std::filesystem::remove(path_(key), error);
+		stats_.misses++;
+		return false;
+	}
+
+	double const ms = elapsedMs(start);
+	stats_.hits++;
+	stats_.loadMs += ms;
+	stats_.savedMs += std::max(0.0, static_cast<double>(header.compileMs) - ms);
+	return true;
+}
+
+void ProgramBinaryCache::prepare(GLuint program)
+{
+	if (enabled_ && supported_())
+		glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+void ProgramBinaryCache::store(std::uint64_t key, GLuint program, double compileMs)
+{
+	stats_.compileMs += compileMs;
+	if (!enabled_ || !supported_())
+		return;
+
+	GLint linked = 0, length = 0;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (!linked || length <= 0)
+		return;
+
+	std::vector<char> binary(static_cast<size_t>(length));
+	GLenum format = 0;
+	GLsizei written = 0;
+	glGetProgramBinary(program, length, &written, &format, binary.data());
+	if (written <= 0)
+		return;
+
+	std::error_code error;
+	std::filesystem::create_directories(directory_, error);
+
+	FileHeader header;
+	header.format = format;
+	header.key = key;
+	header.length = static_cast<std::uint32_t>(written);
+	header.compileMs = static_cast<float>(compileMs);
+
+	std::ofstream file(path_(key), std::ios::binary | std::ios::trunc);
+	file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+	file.write(binary.data(), written);
+	if (!file)
+		std::cerr << "[ProgramBinaryCache ERROR] cannot write " << path_(key) << std::endl;
+}
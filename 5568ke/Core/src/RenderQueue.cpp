@@ -0,0 +1,103 @@
+#include "RenderQueue.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// Fold an id of arbitrary width into the given number of bits
+std::uint64_t foldBits(std::uint32_t value, unsigned bits)
+{
+	std::uint32_t const mask = (1u << bits) - 1u;
+	std::uint32_t folded = 0;
+	while (value) {
+		folded ^= value & mask;
+		value >>= bits;
+	}
+	return folded;
+}
+} // namespace
+
+glm::mat3 computeNormalMatrix(glm::mat4 const& model)
+{
+	glm::mat3 const m(model);
+
+	// R * s has the inverse transpose R / s, so scaling the columns back is enough
+	float const lengthSquared = glm::dot(m[0], m[0]);
+	float const tolerance = 1e-4f * lengthSquared;
+	bool const uniform = std::abs(glm::dot(m[1], m[1]) - lengthSquared) <= tolerance && std::abs(glm::dot(m[2], m[2]) - lengthSquared) <= tolerance &&
+											 std::abs(glm::dot(m[0], m[1])) <= tolerance && std::abs(glm::dot(m[0], m[2])) <= tolerance &&
+											 std::abs(glm::dot(m[1], m[2])) <= tolerance;
+	if (uniform && lengthSquared > 0.0f)
+		return m * (1.0f / lengthSquared);
+
+	return glm::transpose(glm::inverse(m));
+}
+
+std::uint64_t RenderQueue::makeKey(std::uint32_t program, std::uint32_t material, std::uint32_t textureSet, std::uint32_t vao, float depth)
+{
+	std::uint64_t const depthBits = static_cast<std::uint64_t>(std::clamp(depth, 0.0f, 1.0f) * 65535.0f);
+
+	return (foldBits(program, 8) << 56) | (foldBits(material, 16) << 40) | (foldBits(textureSet, 12) << 28) | (foldBits(vao, 12) << 16) | depthBits;
+}
+
+void RenderQueue::clear()
+{
+	items_.clear();
+	objects_.clear();
+	instances_.clear();
+}
+
+std::uint32_t RenderQueue::addObject(glm::mat4 const& transform, int boneBase)
+{
+	RenderObject object;
+	object.transform = transform;
+	object.normalMatrix = computeNormalMatrix(transform);
+	object.boneBase = boneBase;
+	objects_.push_back(object);
+	return static_cast<std::uint32_t>(objects_.size() - 1);
+}
+
+std::uint32_t RenderQueue::addInstances(glm::mat4 const* transforms, size_t count)
+{
+	std::uint32_t const first = static_cast<std::uint32_t>(instances_.size());
+	instances_.reserve(instances_.size() + count);
+	for (size_t i = 0; i < count; i++)
+		instances_.push_back(InstanceData{transforms[i], computeNormalMatrix(transforms[i])});
+	return first;
+}
+
+void RenderQueue::sort()
+{
+	if (items_.size() < 2)
+		return;
+
+	scratch_.resize(items_.size());
+
+	std::vector<DrawItem>* src = &items_;
+	std::vector<DrawItem>* dst = &scratch_;
+
+	for (unsigned shift = 0; shift < 64; shift += 8) {
+		size_t counts[256] = {};
+		for (DrawItem const& item : *src)
+			counts[(item.key >> shift) & 0xFF]++;
+
+		// All keys share this digit, the pass would be a plain copy
+		if (counts[(src->front().key >> shift) & 0xFF] == src->size())
+			continue;
+
+		size_t offset = 0;
+		for (size_t& count : counts) {
+			size_t const c = count;
+			count = offset;
+			offset += c;
+		}
+
+		for (DrawItem const& item : *src)
+			(*dst)[counts[(item.key >> shift) & 0xFF]++] = item;
+
+		std::swap(src, dst);
+	}
+
+	if (src != &items_)
+		items_.swap(scratch_);
+}
@@ -1,39 +1,56 @@
 #include "include_5568ke.hpp"
 
+#include <algorithm>
+
+#include "Frustum.hpp"
+#include "GLStateCache.hpp"
 #include "Renderer.hpp"
+#include "UniformBlocks.hpp"
+
+// What every entity used to send on its own: view, proj, lightPos, lightColor, lightIntensity, viewPos
+static size_t const PER_ENTITY_FRAME_UNIFORM_BYTES = 2 * sizeof(glm::mat4) + 3 * sizeof(glm::vec3) + sizeof(float);
+
+static UniformHandle const MODEL_UNIFORM = Shader::uniform("model");
+static UniformHandle const NORMAL_MATRIX_UNIFORM = Shader::uniform("normalMatrix");
+static UniformHandle const BONE_MATRICES_UNIFORM = Shader::uniform("boneMatrices");
+static UniformHandle const BONE_OFFSET_UNIFORM = Shader::uniform("boneOffset");
+
+// Fewer copies than this are cheaper as regular draws than re-pointing the instance attributes
+static size_t const MIN_INSTANCES_PER_BATCH = 2;
 
 void Renderer::setupDefaultRenderer()
 {
-	// Create default shaders_
-	auto blinnPhongShader = std::make_unique<Shader>();
-	blinnPhongShader->resetShader("assets/shaders/blinn.vert", "assets/shaders/blinn.frag");
+	// Variants (skinned, instanced, per material textures) are compiled when first drawn
+	shaderLibrary_.setSources("assets/shaders/blinn.vert", "assets/shaders/blinn.frag");
 
-	// Create animated shaders
-	auto animatedBlinnShader = std::make_unique<Shader>();
-	animatedBlinnShader->resetShader("assets/shaders/animated_blinn.vert", "assets/shaders/blinn.frag");
+	bonePalette_.init();
+	skinning_.init();
 
-	// Store in the shader map
-	shaders_["blinn"] = std::move(blinnPhongShader);
-	shaders_["animated_blinn"] = std::move(animatedBlinnShader);
+	glGenBuffers(1, &frameDataUbo_);
+	glBindBuffer(GL_UNIFORM_BUFFER, frameDataUbo_);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameData), nullptr, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_DATA_BINDING, frameDataUbo_);
 
-	// Set default main shader
-	mainShader_ = shaders_["blinn"].get();
-	animatedShader_ = shaders_["animated_blinn"].get();
+	glGenBuffers(1, &instanceVbo_);
 }
 
-void Renderer::beginFrame(int w, int h, glm::vec3 const& c)
+void Renderer::beginFrame(int w, int h, glm::vec3 const& c, Scene const& scene)
 {
 	viewportWidth_ = w;
 	viewportHeight_ = h;
 
+	GLStateCache& state = GLStateCache::getInstance();
+	state.resetFrameCounters();
+
 	glViewport(0, 0, w, h);
 
 	// Enable depth testing
-	glEnable(GL_DEPTH_TEST);
+	state.enable(GL_DEPTH_TEST);
 
 	// Enable face culling to improve performance and avoid interior fragments
-	glEnable(GL_CULL_FACE);
-	glCullFace(GL_BACK);
+	state.enable(GL_CULL_FACE);
+	state.cullFace(GL_BACK);
 
 	// Clear the screen
 	glClearColor(c.r, c.g, c.b, 1.0f);
@@ -41,6 +58,12 @@ void Renderer::beginFrame(int w, int h, glm::vec3 const& c)
 
 	// Reset frame stats
 	currentFrameStats_ = FrameStats();
+
+	bonePalette_.beginFrame();
+	skinning_.beginFrame();
+
+	// Camera and lighting are shared by every draw this frame
+	updateFrameData_(scene);
 }
 
 void Renderer::drawScene(Scene const& scene)
@@ -55,64 +78,324 @@ void Renderer::drawScene(Scene const& scene)
 
 void Renderer::drawModels_(Scene const& scene)
 {
-	if (!mainShader_ || !animatedShader_)
-		return;
+	buildQueue_(scene);
+	queue_.sort();
+
+	// Skin up front, every later draw of these meshes reads the captured vertices
+	if (skinning_.meshesThisFrame() > 0) {
+		bonePalette_.bind();
+		skinning_.run(bonePalette_.segmentBase());
+		currentFrameStats_.preSkinnedMeshes = static_cast<int>(skinning_.meshesThisFrame());
+		currentFrameStats_.preSkinnedVertices = skinning_.verticesThisFrame();
+	}
 
-	// Draw all visible entities
+	submitQueue_();
+
+	// The shared block itself is the only camera/light traffic left
+	size_t const uploaded = currentFrameStats_.frameDataBytes;
+	currentFrameStats_.uniformBytesSaved = currentFrameStats_.uniformBytesSaved > uploaded ? currentFrameStats_.uniformBytesSaved - uploaded : 0;
+}
+
+void Renderer::buildQueue_(Scene const& scene)
+{
+	queue_.clear();
+
+	glm::mat4 const view = scene.cam.view();
+	float const zNear = scene.cam.nearPlane();
+	float const depthRange = scene.cam.farPlane() - zNear;
+	Frustum const frustum = Frustum::fromMatrix(scene.cam.proj() * view);
+
+	// Entity level: batch test whole model bounds in world space
+	culler_.clear();
+	culler_.reserve(scene.ents.size());
+	cullCandidates_.clear();
 	for (auto const& entity : scene.ents) {
 		if (!entity.visible || !entity.model)
 			continue;
 
-		// Choose the appropriate shader based on whether the model has animations
-		Shader* selectedShader = entity.model->hasAnimations ? animatedShader_ : mainShader_;
+		cullCandidates_.push_back(&entity);
+		if (entity.model->boundingBoxes.empty()) {
+			// No bounds, never cull
+			culler_.add(BoundingBox{glm::vec3(-1e30f), glm::vec3(1e30f)});
+		}
+		else if (entity.model->hasAnimations) {
+			// Animated limbs and root motion leave the bind-pose box, bound the current pose instead
+			culler_.add(transformBoundingBox(entity.model->poseBoundingBox(entity.animation.palette()), entity.transform));
+		}
+		else {
+			culler_.add(transformBoundingBox(entity.model->globalBoundingBox, entity.transform));
+		}
+	}
+	culler_.cull(frustum, cullVisibility_);
 
-		// Bind the selected shader
-		selectedShader->bind();
+	// Static meshes are collected per mesh first and emitted as instanced batches below
+	instanceGroupIndex_.clear();
+	activeInstanceGroups_ = 0;
 
-		// Set camera-related uniforms
-		selectedShader->setMat4("view", scene.cam.view());
-		selectedShader->setMat4("proj", scene.cam.proj());
+	for (size_t candidate = 0; candidate < cullCandidates_.size(); candidate++) {
+		if (!cullVisibility_[candidate]) {
+			currentFrameStats_.culledEntities++;
+			continue;
+		}
 
-		// Setup lighting
-		setupLighting_(scene, selectedShader);
+		Entity const& entity = *cullCandidates_[candidate];
+		Model const& model = *entity.model;
 
-		// Draw the model with its transform
-		entity.model->draw(*selectedShader, entity.transform);
+		// View depth of the model center, front to back within equal state
+		glm::vec3 const center = (model.globalBoundingBox.min + model.globalBoundingBox.max) * 0.5f;
+		float const viewDepth = -(view * entity.transform * glm::vec4(center, 1.0f)).z;
+		float const depth = (viewDepth - zNear) / depthRange;
 
-		// Update stats
-		currentFrameStats_.drawCalls++;
 		currentFrameStats_.visibleEntities++;
+		currentFrameStats_.uniformBytesSaved += PER_ENTITY_FRAME_UNIFORM_BYTES;
+
+		if (!model.hasAnimations) {
+			for (size_t meshIndex = 0; meshIndex < model.meshes.size(); meshIndex++) {
+				// Mesh level: test each static mesh on its own
+				if (meshIndex < model.boundingBoxes.size() &&
+						!frustum.intersects(transformBoundingBox(model.boundingBoxes[meshIndex], entity.transform))) {
+					currentFrameStats_.culledMeshes++;
+					continue;
+				}
+
+				InstanceGroup& group = instanceGroup_(&model.meshes[meshIndex], &model.materials);
+				group.transforms.push_back(entity.transform);
+				group.depths.push_back(depth);
+			}
+			continue;
+		}
+
+		// Skinned entities have their own palette, streamed once per entity
+		std::vector<glm::mat4> const& palette = entity.animation.palette();
+		int const boneBase = bonePalette_.upload(palette.data(), palette.size());
+
+		// Bind-pose boxes do not follow skinned meshes, so there is no mesh-level test here
+		if (preSkinning_ && skinning_.ready() && boneBase >= 0) {
+			// Skinned once by the feedback pass, then drawn like a static mesh
+			std::uint32_t const object = queue_.addObject(entity.transform, -1);
+			for (Mesh const& mesh : model.meshes) {
+				// Meshes without weights never move, they skip the feedback pass and draw from their own VAO
+				int const baseVertex = mesh.hasAnimation ? skinning_.add(mesh, boneBase) : -1;
+				pushMeshItems_(0, mesh, model.materials, object, 0, 0, depth, baseVertex);
+			}
+			continue;
+		}
+
+		// Without an uploaded palette the SKINNED variant would read another entity's bones, draw the bind pose instead
+		std::uint32_t const object = queue_.addObject(entity.transform, boneBase);
+		for (Mesh const& mesh : model.meshes)
+			pushMeshItems_(mesh.hasAnimation && boneBase >= 0 ? ShaderFeature::SKINNED : 0, mesh, model.materials, object, 0, 0, depth);
+	}
+
+	// Meshes placed at least MIN_INSTANCES_PER_BATCH times become one instanced draw per primitive
+	for (size_t groupIndex = 0; groupIndex < activeInstanceGroups_; groupIndex++) {
+		InstanceGroup const& group = instanceGroups_[groupIndex];
+		size_t const count = group.transforms.size();
+
+		if (count >= MIN_INSTANCES_PER_BATCH) {
+			std::uint32_t const first = queue_.addInstances(group.transforms.data(), count);
+			float const nearest = *std::min_element(group.depths.begin(), group.depths.end());
+			pushMeshItems_(ShaderFeature::INSTANCED, *group.mesh, *group.materials, 0, first, static_cast<std::uint32_t>(count), nearest);
+
+			currentFrameStats_.instancedBatches++;
+			currentFrameStats_.instancesDrawn += static_cast<int>(count);
+			continue;
+		}
+
+		for (size_t i = 0; i < count; i++) {
+			std::uint32_t const object = queue_.addObject(group.transforms[i], -1);
+			pushMeshItems_(0, *group.mesh, *group.materials, object, 0, 0, group.depths[i]);
+		}
+	}
+}
+
+void Renderer::pushMeshItems_(std::uint32_t geometryFeatures, Mesh const& mesh, MaterialTable const& materials, std::uint32_t object,
+															std::uint32_t firstInstance, std::uint32_t instanceCount, float depth, int baseVertex)
+{
+	unsigned const vao = baseVertex >= 0 ? mesh.skinnedVao(skinning_.outputBuffer()) : instanceCount > 0 ? mesh.instancedVao() : mesh.vao();
+
+	for (Primitive const& prim : mesh.primitives) {
+		Material const* material = materialOf(prim, materials);
+
+		// Smallest variant covering what the geometry and the material use
+		Shader* shader = shaderLibrary_.get(geometryFeatures | (material ? material->shaderFeatures() : 0));
+
+		DrawItem item;
+		item.shader = shader;
+		item.material = material;
+		item.mesh = &mesh;
+		item.primitive = &prim;
+		item.vao = vao;
+		item.object = object;
+		item.firstInstance = firstInstance;
+		item.instanceCount = instanceCount;
+		item.baseVertex = baseVertex;
+
+		std::uint32_t materialId = static_cast<std::uint32_t>(reinterpret_cast<std::uintptr_t>(material) >> 4);
+		std::uint32_t textureSet = material ? material->textureSetId() : 0;
+		item.key = RenderQueue::makeKey(shader->id(), materialId, textureSet, vao, depth);
+		queue_.push(item);
+	}
+}
+
+Renderer::InstanceGroup& Renderer::instanceGroup_(Mesh const* mesh, MaterialTable const* materials)
+{
+	auto [it, inserted] = instanceGroupIndex_.try_emplace(mesh, activeInstanceGroups_);
+	if (inserted) {
+		// Groups are recycled across frames to keep their vectors' capacity
+		if (activeInstanceGroups_ == instanceGroups_.size())
+			instanceGroups_.emplace_back();
+
+		InstanceGroup& group = instanceGroups_[activeInstanceGroups_++];
+		group.mesh = mesh;
+		group.materials = materials;
+		group.transforms.clear();
+		group.depths.clear();
 	}
+	return instanceGroups_[it->second];
+}
+
+void Renderer::uploadInstances_()
+{
+	std::vector<InstanceData> const& instances = queue_.instances();
+	if (instances.empty())
+		return;
+
+	size_t const bytes = instances.size() * sizeof(InstanceData);
+	glBindBuffer(GL_ARRAY_BUFFER, instanceVbo_);
+	while (instanceVboCapacity_ < bytes)
+		instanceVboCapacity_ = instanceVboCapacity_ ? instanceVboCapacity_ * 2 : 64 * sizeof(InstanceData);
+
+	// Orphan last frame's storage so the upload does not wait on draws still reading it
+	glBufferData(GL_ARRAY_BUFFER, instanceVboCapacity_, nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, instances.data());
 }
 
-void Renderer::setupLighting_(Scene const& scene, Shader* shader)
+void Renderer::submitQueue_()
 {
-	if (!shader)
+	if (queue_.empty())
 		return;
 
-	// Set light positions and properties
-	// This implementation assumes a simple lighting model like in the original code
+	// Palettes of all skinned entities live in one buffer, bind it once
+	bonePalette_.bind();
+
+	// Matrices of every instanced batch go up in a single upload
+	uploadInstances_();
+
+	// Object bone bases are relative to this frame's palette segment
+	int const paletteBase = bonePalette_.segmentBase();
+
+	Shader* boundShader = nullptr;
+	Material const* boundMaterial = nullptr;
+	unsigned boundVao = 0;
+	std::uint32_t boundObject = ~0u;
+	std::uint32_t boundFirstInstance = ~0u;
+
+	for (DrawItem const& item : queue_.items()) {
+		// Program change invalidates everything that is per-program uniform state
+		if (item.shader != boundShader) {
+			boundShader = item.shader;
+			boundShader->bind();
+			boundShader->setInt(BONE_MATRICES_UNIFORM, BonePaletteBuffer::TEXTURE_SLOT);
+			boundMaterial = nullptr;
+			boundObject = ~0u;
+			currentFrameStats_.programBinds++;
+		}
+
+		if (item.instanceCount == 0 && item.object != boundObject) {
+			boundObject = item.object;
+			RenderObject const& object = queue_.object(item.object);
+			boundShader->setMat4(MODEL_UNIFORM, object.transform);
+			boundShader->setMat3(NORMAL_MATRIX_UNIFORM, object.normalMatrix);
+			if (object.boneBase >= 0)
+				boundShader->setInt(BONE_OFFSET_UNIFORM, paletteBase + object.boneBase);
+			currentFrameStats_.objectUniformUpdates++;
+		}
+
+		if (item.vao != boundVao) {
+			boundVao = item.vao;
+			GLStateCache::getInstance().bindVertexArray(boundVao);
+			boundFirstInstance = ~0u;
+			currentFrameStats_.vaoBinds++;
+		}
+
+		if (item.instanceCount > 0 && item.firstInstance != boundFirstInstance) {
+			boundFirstInstance = item.firstInstance;
+			item.mesh->bindInstanceAttributes(instanceVbo_, item.firstInstance * sizeof(InstanceData));
+		}
+
+		if (item.material && item.material != boundMaterial) {
+			boundMaterial = item.material;
+			boundMaterial->bind(*boundShader);
+			currentFrameStats_.materialBinds++;
+		}
+
+		if (item.instanceCount > 0)
+			item.mesh->drawPrimitiveInstanced(*item.primitive, static_cast<int>(item.instanceCount));
+		else if (item.baseVertex >= 0)
+			item.mesh->drawPrimitiveBaseVertex(*item.primitive, item.baseVertex);
+		else
+			item.mesh->drawPrimitive(*item.primitive);
+		currentFrameStats_.drawCalls++;
+	}
+
+	currentFrameStats_.drawItems = static_cast<int>(queue_.size());
+}
+
+void Renderer::updateFrameData_(Scene const& scene)
+{
+	if (!frameDataUbo_)
+		return;
+
+	FrameData data;
+	data.view = scene.cam.view();
+	data.proj = scene.cam.proj();
+	data.viewPos = glm::vec4(scene.cam.position(), 1.0f);
+
+	// Only the first light is used by the shaders for now
 	if (!scene.lights.empty()) {
-		shader->setVec3("lightPos", scene.lights[0].position);
-		shader->setVec3("lightColor", scene.lights[0].color);
-		shader->setFloat("lightIntensity", scene.lights[0].intensity);
+		data.lightPos = glm::vec4(scene.lights[0].position, 1.0f);
+		data.lightColor = glm::vec4(scene.lights[0].color, scene.lights[0].intensity);
+	}
+	else {
+		data.lightPos = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		data.lightColor = glm::vec4(0.0f);
 	}
 
-	shader->setVec3("viewPos", scene.cam.position());
+	glBindBuffer(GL_UNIFORM_BUFFER, frameDataUbo_);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameData), &data);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
 
-	// For more complex lighting, you could iterate through lights and set arrays of uniforms
+	currentFrameStats_.frameDataBytes = sizeof(FrameData);
 }
 
 void Renderer::endFrame()
 {
-	glBindVertexArray(0);
-	glUseProgram(0);
+	bonePalette_.endFrame();
+
+	GLStateCache::getInstance().bindVertexArray(0);
+	GLStateCache::getInstance().useProgram(0);
+}
+
+void Renderer::cleanup()
+{
+	bonePalette_.cleanup();
+	skinning_.cleanup();
+
+	if (frameDataUbo_ != 0) {
+		glDeleteBuffers(1, &frameDataUbo_);
+		frameDataUbo_ = 0;
+	}
+
+	if (instanceVbo_ != 0) {
+		glDeleteBuffers(1, &instanceVbo_);
+		instanceVbo_ = 0;
+		instanceVboCapacity_ = 0;
+	}
 }
 
 Renderer::~Renderer()
 {
 	// Clean up shader resources
-	shaders_.clear();
-	mainShader_ = nullptr;
-	animatedShader_ = nullptr;
+	shaderLibrary_.clear();
 }
\ No newline at end of file
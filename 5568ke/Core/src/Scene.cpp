@@ -56,7 +56,7 @@ void Camera::updateMatrices(GLFWwindow* w)
 	int fbW, fbH;
 	glfwGetFramebufferSize(w, &fbW, &fbH);
 	view_ = glm::lookAt(pos_, pos_ + front_, glm::vec3(0, 1, 0));
-	proj_ = glm::perspective(glm::radians(45.0f), float(fbW) / fbH, 0.1f, 100.f);
+	proj_ = glm::perspective(glm::radians(45.0f), float(fbW) / fbH, zNear_, zFar_);
 }
 
 // Implementation of new Camera methods
@@ -173,6 +173,13 @@ void Scene::addEntity(Model* model, glm::mat4 const& transform, std::string cons
 	entity.model = model;
 	entity.transform = transform;
 
+	// Every entity gets its own playback state, starting with the first clip
+	if (model->hasAnimations) {
+		entity.animation.initialize(model);
+		if (entity.animation.setAnimation(0))
+			entity.animation.play();
+	}
+
 	// Set name (use auto-generated if empty)
 	entity.name = name.empty() ? "entity_" + std::to_string(ents.size()) : name;
 
@@ -204,6 +211,22 @@ void Scene::removeEntity(std::string const& name)
 	}
 }
 
+bool Scene::replaceModel(std::string const& name, Model* model)
+{
+	Entity* entity = findEntity(name);
+	if (!entity || !model)
+		return false;
+
+	entity->model = model;
+	entity->animation = AnimationInstance();
+	if (model->hasAnimations) {
+		entity->animation.initialize(model);
+		if (entity->animation.setAnimation(0))
+			entity->animation.play();
+	}
+	return true;
+}
+
 // Implementation for adding light
 void Scene::addLight(glm::vec3 const& position, glm::vec3 const& color, float intensity)
 {
@@ -1,11 +1,41 @@
 #include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <chrono>
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <unordered_map>
 
+#include "GLStateCache.hpp"
+#include "ProgramBinaryCache.hpp"
 #include "Shader.hpp"
+#include "UniformBlocks.hpp"
 
 namespace {
+// Global uniform name registry backing UniformHandle ids
+std::unordered_map<std::string, unsigned>& handleRegistry()
+{
+	static std::unordered_map<std::string, unsigned> registry;
+	return registry;
+}
+
+std::vector<std::string>& handleNames()
+{
+	static std::vector<std::string> names;
+	return names;
+}
+
+// FNV-1a, good enough for short uniform names
+std::uint32_t hashName(char const* name)
+{
+	std::uint32_t h = 2166136261u;
+	for (; *name; ++name) {
+		h ^= static_cast<unsigned char>(*name);
+		h *= 16777619u;
+	}
+	return h;
+}
+
 unsigned compileStage(std::string const& src, GLenum type)
 {
 	unsigned id = glCreateShader(type);
@@ -33,29 +63,98 @@ std::string loadFile(std::string const& path)
 	ss << f.rdbuf();
 	return ss.str();
 }
+
+// Insert `#define`s after the #version line, which has to stay first
+std::string injectDefines(std::string const& source, std::vector<std::string> const& defines)
+{
+	if (defines.empty())
+		return source;
+
+	std::string block;
+	for (std::string const& define : defines)
+		block += "#define " + define + "\n";
+
+	size_t const version = source.find("#version");
+	size_t const lineEnd = version == std::string::npos ? std::string::npos : source.find('\n', version);
+	if (lineEnd == std::string::npos)
+		return block + source;
+
+	// Keep compiler messages pointing at the lines of the file
+	return source.substr(0, lineEnd + 1) + block + "#line 2\n" + source.substr(lineEnd + 1);
+}
 } // namespace
 
-void Shader::resetShader(std::string const& v, std::string const& f)
+void Shader::resetShader(std::string const& v, std::string const& f, std::vector<std::string> const& defines)
 {
 	vsPath_ = v;
 	fsPath_ = f;
+	defines_ = defines;
+	feedbackVaryings_.clear();
+	reload();
+}
+
+void Shader::resetFeedbackShader(std::string const& v, std::vector<std::string> const& varyings)
+{
+	vsPath_ = v;
+	fsPath_.clear();
+	defines_.clear();
+	feedbackVaryings_ = varyings;
 	reload();
 }
 
 void Shader::reload()
 {
-	if (vsPath_.empty() || fsPath_.empty())
+	bool const feedback = !feedbackVaryings_.empty();
+	if (vsPath_.empty() || (fsPath_.empty() && !feedback))
 		return;
 
-	if (program_)
+	// Unbind first so the cache never holds a deleted (and possibly recycled) name
+	if (program_) {
+		GLStateCache::getInstance().useProgram(0);
 		glDeleteProgram(program_);
+	}
 
-	unsigned vs = compileStage(loadFile(vsPath_), GL_VERTEX_SHADER);
-	unsigned fs = compileStage(loadFile(fsPath_), GL_FRAGMENT_SHADER);
+	std::string const vsSource = injectDefines(loadFile(vsPath_), defines_);
+	std::string const fsSource = fsPath_.empty() ? std::string() : injectDefines(loadFile(fsPath_), defines_);
 
 	program_ = glCreateProgram();
+
+	// A binary from an earlier run skips compiling and linking entirely
+	ProgramBinaryCache& cache = ProgramBinaryCache::getInstance();
+	std::uint64_t const cacheKey = cache.key({vsSource, fsSource}, feedbackVaryings_);
+	if (!cache.load(cacheKey, program_)) {
+		auto const start = std::chrono::steady_clock::now();
+		cache.prepare(program_);
+		linkFromSource_(vsSource, fsSource);
+		cache.store(cacheKey, program_, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	}
+
+	// Attach shared uniform blocks to their fixed binding points
+	GLuint frameDataIndex = glGetUniformBlockIndex(program_, "FrameData");
+	if (frameDataIndex != GL_INVALID_INDEX)
+		glUniformBlockBinding(program_, frameDataIndex, FRAME_DATA_BINDING);
+
+	// Locations may change between links, rebuild the cache for the new program
+	buildUniformTable_();
+}
+
+void Shader::linkFromSource_(std::string const& vsSource, std::string const& fsSource)
+{
+	unsigned vs = compileStage(vsSource, GL_VERTEX_SHADER);
+	unsigned fs = fsSource.empty() ? 0 : compileStage(fsSource, GL_FRAGMENT_SHADER);
+
 	glAttachShader(program_, vs);
-	glAttachShader(program_, fs);
+	if (fs)
+		glAttachShader(program_, fs);
+
+	// Captured outputs are part of the link, declare them first
+	if (!feedbackVaryings_.empty()) {
+		std::vector<char const*> names;
+		for (std::string const& varying : feedbackVaryings_)
+			names.push_back(varying.c_str());
+		glTransformFeedbackVaryings(program_, static_cast<GLsizei>(names.size()), names.data(), GL_INTERLEAVED_ATTRIBS);
+	}
+
 	glLinkProgram(program_);
 
 	GLint success;
@@ -66,11 +165,13 @@ void Shader::reload()
 		std::cerr << "[Shader ERROR] Vertex shader compilation failed: " << infoLog << std::endl;
 	}
 
-	glGetShaderiv(fs, GL_COMPILE_STATUS, &success);
-	if (!success) {
-		char infoLog[512];
-		glGetShaderInfoLog(fs, 512, NULL, infoLog);
-		std::cerr << "[Shader ERROR] Fragment shader compilation failed: " << infoLog << std::endl;
+	if (fs) {
+		glGetShaderiv(fs, GL_COMPILE_STATUS, &success);
+		if (!success) {
+			char infoLog[512];
+			glGetShaderInfoLog(fs, 512, NULL, infoLog);
+			std::cerr << "[Shader ERROR] Fragment shader compilation failed: " << infoLog << std::endl;
+		}
 	}
 
 	// Check program linking status
@@ -82,54 +183,138 @@ void Shader::reload()
 	}
 
 	glDeleteShader(vs);
-	glDeleteShader(fs);
+	if (fs)
+		glDeleteShader(fs);
 }
 
-void Shader::bind() const { glUseProgram(program_); }
+void Shader::buildUniformTable_()
+{
+	uniformTable_.clear();
+	handleLocations_.clear();
 
-void Shader::unbind() const { glUseProgram(0); }
+	GLint linked = 0;
+	glGetProgramiv(program_, GL_LINK_STATUS, &linked);
+	if (!linked)
+		return;
 
-void Shader::setMat4(char const* name, glm::mat4 const& mat) const
-{
-	int loc = glGetUniformLocation(program_, name);
-	// if (loc == -1)
-	// std::cerr << "[Shader] Warning: uniform '" << name << "' not found.\n";
+	GLint activeCount = 0, maxNameLength = 0;
+	glGetProgramiv(program_, GL_ACTIVE_UNIFORMS, &activeCount);
+	glGetProgramiv(program_, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
 
-	glUniformMatrix4fv(glGetUniformLocation(program_, name), 1, GL_FALSE, glm::value_ptr(mat));
+	// Collect name/location pairs first, array elements are expanded to "name[i]"
+	std::vector<std::pair<std::string, int>> entries;
+	std::vector<char> nameBuffer(std::max(maxNameLength, 1));
+	for (GLint i = 0; i < activeCount; i++) {
+		GLsizei length = 0;
+		GLint size = 0;
+		GLenum type = 0;
+		glGetActiveUniform(program_, i, static_cast<GLsizei>(nameBuffer.size()), &length, &size, &type, nameBuffer.data());
+
+		std::string name(nameBuffer.data(), length);
+		int loc = glGetUniformLocation(program_, name.c_str());
+		if (loc < 0)
+			continue; // uniform block member
+
+		// Arrays are reported as "name[0]", register the base name as well
+		std::string::size_type bracket = name.find('[');
+		if (bracket == std::string::npos) {
+			entries.emplace_back(name, loc);
+			continue;
+		}
+
+		std::string base = name.substr(0, bracket);
+		entries.emplace_back(base, loc);
+		entries.emplace_back(base + "[0]", loc);
+		for (GLint e = 1; e < size; e++) {
+			std::string element = base + "[" + std::to_string(e) + "]";
+			entries.emplace_back(element, glGetUniformLocation(program_, element.c_str()));
+		}
+	}
+
+	// Power-of-two capacity at most half full keeps linear probing short
+	size_t capacity = 16;
+	while (capacity < entries.size() * 2)
+		capacity *= 2;
+	uniformTable_.resize(capacity);
+
+	for (auto& [name, loc] : entries) {
+		std::uint32_t h = hashName(name.c_str());
+		size_t idx = h & (capacity - 1);
+		while (!uniformTable_[idx].name.empty())
+			idx = (idx + 1) & (capacity - 1);
+		uniformTable_[idx].hash = h;
+		uniformTable_[idx].location = loc;
+		uniformTable_[idx].name = std::move(name);
+	}
 }
 
-void Shader::setVec3(char const* name, glm::vec3 const& vec) const
+void Shader::bind() const { GLStateCache::getInstance().useProgram(program_); }
+
+void Shader::unbind() const { GLStateCache::getInstance().useProgram(0); }
+
+UniformHandle Shader::uniform(char const* name)
 {
-	int loc = glGetUniformLocation(program_, name);
-	// if (loc == -1)
-	// std::cerr << "[Shader] Warning: uniform '" << name << "' not found.\n";
+	auto& registry = handleRegistry();
+	auto it = registry.find(name);
+	if (it != registry.end())
+		return UniformHandle{it->second};
 
-	glUniform3fv(glGetUniformLocation(program_, name), 1, glm::value_ptr(vec));
+	unsigned id = static_cast<unsigned>(handleNames().size());
+	handleNames().emplace_back(name);
+	registry.emplace(name, id);
+	return UniformHandle{id};
 }
 
-void Shader::setFloat(char const* name, float value) const
+int Shader::location(char const* name) const
 {
-	int loc = glGetUniformLocation(program_, name);
-	// if (loc == -1)
-	// std::cerr << "[Shader] Warning: uniform '" << name << "' not found.\n";
+	if (uniformTable_.empty())
+		return -1;
 
-	glUniform1f(glGetUniformLocation(program_, name), value);
+	std::uint32_t h = hashName(name);
+	size_t mask = uniformTable_.size() - 1;
+	for (size_t idx = h & mask;; idx = (idx + 1) & mask) {
+		UniformSlot const& slot = uniformTable_[idx];
+		if (slot.name.empty())
+			return -1;
+		if (slot.hash == h && slot.name == name)
+			return slot.location;
+	}
 }
 
-void Shader::setInt(char const* name, int value) const
+int Shader::location(UniformHandle handle) const
 {
-	int loc = glGetUniformLocation(program_, name);
-	// if (loc == -1)
-	// std::cerr << "[Shader] Warning: uniform '" << name << "' not found.\n";
+	if (!handle.valid())
+		return -1;
+
+	if (handle.id >= handleLocations_.size())
+		handleLocations_.resize(handle.id + 1, -2);
 
-	glUniform1i(glGetUniformLocation(program_, name), value);
+	int& loc = handleLocations_[handle.id];
+	if (loc == -2)
+		loc = location(handleNames()[handle.id].c_str());
+	return loc;
 }
 
-void Shader::setBool(char const* name, bool value) const
-{
-	int loc = glGetUniformLocation(program_, name);
-	// if (loc == -1)
-	// std::cerr << "[Shader] Warning: uniform '" << name << "' not found.\n";
+void Shader::setMat4(UniformHandle handle, glm::mat4 const& mat) const { glUniformMatrix4fv(location(handle), 1, GL_FALSE, glm::value_ptr(mat)); }
+
+void Shader::setMat3(UniformHandle handle, glm::mat3 const& mat) const { glUniformMatrix3fv(location(handle), 1, GL_FALSE, glm::value_ptr(mat)); }
+
+void Shader::setVec3(UniformHandle handle, glm::vec3 const& vec) const { glUniform3fv(location(handle), 1, glm::value_ptr(vec)); }
+
+void Shader::setFloat(UniformHandle handle, float value) const { glUniform1f(location(handle), value); }
+
+void Shader::setInt(UniformHandle handle, int value) const { glUniform1i(location(handle), value); }
+
+void Shader::setBool(UniformHandle handle, bool value) const { glUniform1i(location(handle), static_cast<int>(value)); }
+
+void Shader::setMat4(char const* name, glm::mat4 const& mat) const { glUniformMatrix4fv(location(name), 1, GL_FALSE, glm::value_ptr(mat)); }
+
+void Shader::setMat3(char const* name, glm::mat3 const& mat) const { glUniformMatrix3fv(location(name), 1, GL_FALSE, glm::value_ptr(mat)); }
+
+void Shader::setVec3(char const* name, glm::vec3 const& vec) const { glUniform3fv(location(name), 1, glm::value_ptr(vec)); }
+
+void Shader::setFloat(char const* name, float value) const { glUniform1f(location(name), value); }
+
+void Shader::setInt(char const* name, int value) const { glUniform1i(location(name), value); }
 
-	glUniform1i(glGetUniformLocation(program_, name), static_cast<int>(value));
-}
\ No newline at end of file
+void Shader::setBool(char const* name, bool value) const { glUniform1i(location(name), static_cast<int>(value)); }
@@ -0,0 +1,44 @@
+#include "ShaderLibrary.hpp"
+
+#include <iostream>
+
+namespace {
+char const* const FEATURE_NAMES[ShaderFeature::COUNT] = {"SKINNED", "INSTANCED", "HAS_BASE_MAP", "HAS_OVERLAY", "ALPHA_TEST"};
+} // namespace
+
+void ShaderLibrary::setSources(std::string const& vertPath, std::string const& fragPath)
+{
+	vertPath_ = vertPath;
+	fragPath_ = fragPath;
+	variants_.clear();
+}
+
+Shader* ShaderLibrary::get(std::uint32_t features)
+{
+	auto it = variants_.find(features);
+	if (it != variants_.end())
+		return it->second.get();
+
+	std::vector<std::string> const defines = definesFor(features);
+	auto shader = std::make_unique<Shader>();
+	shader->resetShader(vertPath_, fragPath_, defines);
+
+	std::cout << "[ShaderLibrary] Compiled variant";
+	for (std::string const& define : defines)
+		std::cout << ' ' << define;
+	if (defines.empty())
+		std::cout << " (base)";
+	std::cout << ", " << variants_.size() + 1 << " cached" << std::endl;
+
+	return variants_.emplace(features, std::move(shader)).first->second.get();
+}
+
+std::vector<std::string> ShaderLibrary::definesFor(std::uint32_t features)
+{
+	std::vector<std::string> defines;
+	for (std::uint32_t bit = 0; bit < ShaderFeature::COUNT; bit++) {
+		if (features & (1u << bit))
+			defines.emplace_back(FEATURE_NAMES[bit]);
+	}
+	return defines;
+}
@@ -0,0 +1,99 @@
+#include "SkinningStage.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#include "BonePaletteBuffer.hpp"
+#include "GLStateCache.hpp"
+#include "Mesh.hpp"
+
+static UniformHandle const BONE_MATRICES_UNIFORM = Shader::uniform("boneMatrices");
+static UniformHandle const BONE_OFFSET_UNIFORM = Shader::uniform("boneOffset");
+
+SkinningStage::~SkinningStage() { cleanup(); }
+
+void SkinningStage::init(size_t vertices)
+{
+	cleanup();
+
+	shader_ = std::make_unique<Shader>();
+	shader_->resetFeedbackShader("assets/shaders/skin_feedback.vert", {"skinnedPosition", "skinnedNormal", "skinnedUV"});
+
+	capacity_ = std::max<size_t>(vertices, 1);
+	glGenBuffers(1, &buffer_);
+	glBindBuffer(GL_ARRAY_BUFFER, buffer_);
+	glBufferData(GL_ARRAY_BUFFER, capacity_ * sizeof(SkinnedVertex), nullptr, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void SkinningStage::beginFrame()
+{
+	jobs_.clear();
+	vertexCount_ = 0;
+}
+
+int SkinningStage::add(Mesh const& mesh, int boneBase)
+{
+	Job job;
+	job.mesh = &mesh;
+	job.boneBase = boneBase;
+	job.baseVertex = vertexCount_;
+	job.vertexCount = mesh.vertices.size();
+	jobs_.push_back(job);
+
+	vertexCount_ += job.vertexCount;
+	return static_cast<int>(job.baseVertex);
+}
+
+void SkinningStage::run(int paletteBase)
+{
+	if (!ready() || jobs_.empty())
+		return;
+
+	// Ranges are handed out before anything is written, so the buffer can grow here without losing output
+	if (vertexCount_ > capacity_) {
+		while (capacity_ < vertexCount_)
+			capacity_ *= 2;
+		glBindBuffer(GL_ARRAY_BUFFER, buffer_);
+		glBufferData(GL_ARRAY_BUFFER, capacity_ * sizeof(SkinnedVertex), nullptr, GL_DYNAMIC_COPY);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		std::cout << "[SkinningStage] Output buffer grown to " << capacity_ << " vertices" << std::endl;
+	}
+
+	GLStateCache& state = GLStateCache::getInstance();
+	shader_->bind();
+	shader_->setInt(BONE_MATRICES_UNIFORM, BonePaletteBuffer::TEXTURE_SLOT);
+
+	// Only the captured vertices matter, nothing reaches the rasterizer
+	state.enable(GL_RASTERIZER_DISCARD);
+
+	for (Job const& job : jobs_) {
+		if (job.vertexCount == 0)
+			continue;
+
+		shader_->setInt(BONE_OFFSET_UNIFORM, paletteBase + job.boneBase);
+		glBindBufferRange(GL_TRANSFORM_FEEDBACK_BUFFER, 0, buffer_, job.baseVertex * sizeof(SkinnedVertex), job.vertexCount * sizeof(SkinnedVertex));
+
+		// Every vertex once, as a point; the index buffer only matters when drawing
+		job.mesh->bind();
+		glBeginTransformFeedback(GL_POINTS);
+		glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(job.vertexCount));
+		glEndTransformFeedback();
+	}
+
+	state.disable(GL_RASTERIZER_DISCARD);
+	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+}
+
+void SkinningStage::cleanup()
+{
+	shader_.reset();
+	jobs_.clear();
+	vertexCount_ = 0;
+
+	if (buffer_ != 0) {
+		glDeleteBuffers(1, &buffer_);
+		buffer_ = 0;
+		capacity_ = 0;
+	}
+}
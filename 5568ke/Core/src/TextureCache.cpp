@@ -0,0 +1,90 @@
+#include "TextureCache.hpp"
+#include "GLStateCache.hpp"
+
+#include <functional>
+
+size_t TextureCache::KeyHash::operator()(Key const& key) const
+{
+	size_t hash = std::hash<std::string>{}(key.file);
+	for (size_t value : {static_cast<size_t>(key.image), static_cast<size_t>(key.sampler)})
+		hash ^= value + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+	return hash;
+}
+
+Texture* TextureCache::acquire(Key const& key, TextureType type, std::string const& path, bool& needsUpload)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	Entry& entry = entries_[key];
+	if (!entry.texture) {
+		entry.texture = std::make_unique<Texture>();
+		entry.texture->type = type;
+		entry.texture->path = path;
+		keys_[entry.texture.get()] = key;
+		stats_.misses++;
+	}
+	else {
+		stats_.hits++;
+	}
+
+	needsUpload = !entry.uploaded;
+	entry.references++;
+	return entry.texture.get();
+}
+
+void TextureCache::markUploaded(Texture* texture)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	auto keyIt = keys_.find(texture);
+	if (keyIt != keys_.end())
+		entries_[keyIt->second].uploaded = true;
+}
+
+void TextureCache::release(Texture* texture)
+{
+	if (!texture)
+		return;
+
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	auto keyIt = keys_.find(texture);
+	if (keyIt == keys_.end())
+		return;
+
+	auto entryIt = entries_.find(keyIt->second);
+	if (--entryIt->second.references > 0)
+		return;
+
+	if (texture->id != 0) {
+		GLStateCache::getInstance().forgetTexture(texture->id);
+		glDeleteTextures(1, &texture->id);
+	}
+	keys_.erase(keyIt);
+	entries_.erase(entryIt);
+}
+
+size_t TextureCache::size() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return entries_.size();
+}
+
+TextureCache::Stats TextureCache::stats() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return stats_;
+}
+
+void TextureCache::cleanup()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	for (auto& [key, entry] : entries_) {
+		if (entry.texture->id != 0) {
+			GLStateCache::getInstance().forgetTexture(entry.texture->id);
+			glDeleteTextures(1, &entry.texture->id);
+		}
+	}
+	entries_.clear();
+	keys_.clear();
+}
@@ -1,10 +1,17 @@
 #define TINYGLTF_IMPLEMENTATION
 #include "include_5568ke.hpp"
 
+#include <string>
+
 #include "Application.hpp"
+#include "Benchmark.hpp"
 
-int main()
+int main(int argc, char** argv)
 {
+	// `--bench <name>` runs a microbenchmark instead of the viewer
+	if (argc >= 2 && std::string(argv[1]) == "--bench")
+		return Benchmark::run(argc >= 3 ? argv[2] : "all");
+
 	Application app;
 	return app.run();
-}
\ No newline at end of file
+}
@@ -68,6 +68,10 @@ private:
 
 	// Animation controls state
 	bool showAnimationControls_ = false;
+	float crossfadeSeconds_ = 0.3f;
+	int layerClip_ = 0;
+	int layerMaskBone_ = -1; // -1 = every bone
+	bool layerAdditive_ = false;
 
 	// Utility functions
 	void refreshFileList();
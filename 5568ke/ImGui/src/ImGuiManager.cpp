@@ -105,39 +105,45 @@ void ImGuiManager::loadSelectedModel(Scene& scene)
 	// Use model name or filename if not provided
 	std::string name = modelName.empty() ? std::filesystem::path(selectedFile).stem().string() : modelName;
 
-	// Load the model
-	auto& registry = ModelRegistry::getInstance();
-	Model* model = registry.loadModel(fullPath, name);
+	// Create transformation matrix
+	glm::mat4 transform = glm::mat4(1.0f);
 
-	if (model) {
-		// Create transformation matrix
-		glm::mat4 transform = glm::mat4(1.0f);
+	// Apply transforms in order: scale, rotate, translate
+	transform = glm::scale(transform, glm::vec3(modelScale));
 
-		// Apply transforms in order: scale, rotate, translate
-		transform = glm::scale(transform, glm::vec3(modelScale));
+	// Apply rotations in XYZ order
+	transform = glm::rotate(transform, modelRotation[0], glm::vec3(1.0f, 0.0f, 0.0f));
+	transform = glm::rotate(transform, modelRotation[1], glm::vec3(0.0f, 1.0f, 0.0f));
+	transform = glm::rotate(transform, modelRotation[2], glm::vec3(0.0f, 0.0f, 1.0f));
 
-		// Apply rotations in XYZ order
-		transform = glm::rotate(transform, modelRotation[0], glm::vec3(1.0f, 0.0f, 0.0f));
-		transform = glm::rotate(transform, modelRotation[1], glm::vec3(0.0f, 1.0f, 0.0f));
-		transform = glm::rotate(transform, modelRotation[2], glm::vec3(0.0f, 0.0f, 1.0f));
+	// Apply translation
+	transform = glm::translate(transform, glm::vec3(modelPosition[0], modelPosition[1], modelPosition[2]));
 
-		// Apply translation
-		transform = glm::translate(transform, glm::vec3(modelPosition[0], modelPosition[1], modelPosition[2]));
+	// Loading the same model again adds another entity, so each placeholder needs a name of its own
+	std::string entityName = name;
+	for (int copy = 2; scene.findEntity(entityName); copy++)
+		entityName = name + "_" + std::to_string(copy);
 
-		// Add to scene
-		registry.addModelToScene(scene, model, name, transform);
+	// Add a placeholder to the scene, replaced once the model finished loading in the background
+	auto& registry = ModelRegistry::getInstance();
+	registry.addModelToScene(scene, registry.placeholderModel(), entityName, transform);
 
-		std::cout << "Model '" << name << "' loaded successfully from " << fullPath << std::endl;
+	registry.loadModelAsync(fullPath, name, glm::vec3(0.0f), glm::vec3(0.0f), 1.0f, [&scene, name, entityName, fullPath](Model* model) {
+		if (model) {
+			scene.replaceModel(entityName, model);
+			std::cout << "Model '" << name << "' loaded successfully from " << fullPath << std::endl;
+		}
+		else {
+			scene.removeEntity(entityName);
+			std::cerr << "Failed to load model from " << fullPath << std::endl;
+		}
+	});
 
-		// Reset input fields
-		modelName = "";
-		modelScale = 1.0f;
-		modelRotation[0] = modelRotation[1] = modelRotation[2] = 0.0f;
-		modelPosition[0] = modelPosition[1] = modelPosition[2] = 0.0f;
-	}
-	else {
-		std::cerr << "Failed to load model from " << fullPath << std::endl;
-	}
+	// Reset input fields
+	modelName = "";
+	modelScale = 1.0f;
+	modelRotation[0] = modelRotation[1] = modelRotation[2] = 0.0f;
+	modelPosition[0] = modelPosition[1] = modelPosition[2] = 0.0f;
 }
 
 void ImGuiManager::drawTransformEditor(glm::mat4& transform)
@@ -307,8 +313,8 @@ void ImGuiManager::drawAnimationControls(Scene& scene)
 		return;
 	}
 
-	// Get animation player from the model
-	AnimationPlayer& player = entity.model->animationPlayer;
+	// Playback state belongs to the entity, other entities sharing the model are unaffected
+	AnimationInstance& player = entity.animation;
 
 	// Display animation name and controls
 	ImGui::Text("Model: %s", entity.name.c_str());
@@ -322,7 +328,7 @@ void ImGuiManager::drawAnimationControls(Scene& scene)
 				std::string animName = player.getAnimationName(static_cast<int>(i));
 				bool isSelected = (currentAnim == animName);
 				if (ImGui::Selectable(animName.c_str(), isSelected)) {
-					player.setAnimation(static_cast<int>(i));
+					player.crossfadeTo(static_cast<int>(i), crossfadeSeconds_);
 				}
 
 				if (isSelected) {
@@ -332,6 +338,9 @@ void ImGuiManager::drawAnimationControls(Scene& scene)
 			ImGui::EndCombo();
 		}
 
+		// Switching clips blends over this long (0 = hard switch)
+		ImGui::SliderFloat("Crossfade", &crossfadeSeconds_, 0.0f, 2.0f, "%.2f s");
+
 		// Playback controls
 		bool isPlaying = player.isPlaying();
 		if (ImGui::Button(isPlaying ? "Pause" : "Play")) {
@@ -352,7 +361,7 @@ void ImGuiManager::drawAnimationControls(Scene& scene)
 		ImGui::SameLine();
 
 		// Loop toggle
-		static bool loop = true;
+		bool loop = player.isLooping();
 		if (ImGui::Checkbox("Loop", &loop)) {
 			player.setLooping(loop);
 		}
@@ -364,7 +373,7 @@ void ImGuiManager::drawAnimationControls(Scene& scene)
 		}
 
 		// Animation speed slider
-		static float speed = 1.0f;
+		float speed = player.getSpeed();
 		if (ImGui::SliderFloat("Speed", &speed, 0.1f, 3.0f, "%.2f")) {
 			player.setSpeed(speed);
 		}
@@ -372,6 +381,64 @@ void ImGuiManager::drawAnimationControls(Scene& scene)
 		// Animation duration display
 		float duration = player.getCurrentDuration();
 		ImGui::Text("Duration: %.2f seconds", duration);
+
+		// Layers blended on top of the current clip
+		if (ImGui::CollapsingHeader("Layers")) {
+			Skeleton const& skeleton = entity.model->skeleton;
+			std::vector<AnimationLayer> const& layers = player.layers();
+			int removeIndex = -1;
+			for (size_t i = 0; i < layers.size(); i++) {
+				ImGui::PushID(static_cast<int>(i));
+				float weight = layers[i].weight;
+				std::string label = layers[i].clip->name + (layers[i].blend == LayerBlend::Additive ? " (additive)" : "");
+				if (ImGui::SliderFloat(label.c_str(), &weight, 0.0f, 1.0f, "%.2f")) {
+					player.setLayerWeight(static_cast<int>(i), weight);
+				}
+				ImGui::SameLine();
+				if (ImGui::SmallButton("Remove")) {
+					removeIndex = static_cast<int>(i);
+				}
+				ImGui::PopID();
+			}
+			if (removeIndex >= 0) {
+				player.removeLayer(removeIndex);
+			}
+
+			layerClip_ = std::clamp(layerClip_, 0, static_cast<int>(animCount) - 1);
+			if (ImGui::BeginCombo("Layer clip", player.getAnimationName(layerClip_).c_str())) {
+				for (size_t i = 0; i < animCount; i++) {
+					if (ImGui::Selectable(player.getAnimationName(static_cast<int>(i)).c_str(), layerClip_ == static_cast<int>(i))) {
+						layerClip_ = static_cast<int>(i);
+					}
+				}
+				ImGui::EndCombo();
+			}
+
+			if (layerMaskBone_ >= static_cast<int>(skeleton.bones.size())) {
+				layerMaskBone_ = -1;
+			}
+			char const* maskName = layerMaskBone_ < 0 ? "(all bones)" : skeleton.bones[layerMaskBone_].name.c_str();
+			if (ImGui::BeginCombo("Mask root", maskName)) {
+				if (ImGui::Selectable("(all bones)", layerMaskBone_ < 0)) {
+					layerMaskBone_ = -1;
+				}
+				for (size_t i = 0; i < skeleton.bones.size(); i++) {
+					ImGui::PushID(static_cast<int>(i));
+					if (ImGui::Selectable(skeleton.bones[i].name.c_str(), layerMaskBone_ == static_cast<int>(i))) {
+						layerMaskBone_ = static_cast<int>(i);
+					}
+					ImGui::PopID();
+				}
+				ImGui::EndCombo();
+			}
+
+			ImGui::Checkbox("Additive", &layerAdditive_);
+			ImGui::SameLine();
+			if (ImGui::Button("Add layer")) {
+				std::vector<float> mask = layerMaskBone_ < 0 ? std::vector<float>{} : skeleton.makeBoneMask(layerMaskBone_);
+				player.addLayer(layerClip_, layerAdditive_ ? LayerBlend::Additive : LayerBlend::Override, 1.0f, std::move(mask));
+			}
+		}
 	}
 	else {
 		ImGui::Text("No animations available");
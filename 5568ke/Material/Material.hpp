@@ -1,6 +1,8 @@
 #pragma once
 
 #include <glm/glm.hpp>
+#include <cstdint>
+#include <memory>
 #include <vector>
 
 #include "Shader.hpp"
@@ -8,5 +10,16 @@
 
 class Material {
 public:
+	virtual ~Material() = default;
+
 	virtual void bind(Shader& shader) const = 0;
+
+	// Identifies the set of textures bound by bind(), used to sort draws
+	virtual std::uint32_t textureSetId() const { return 0; }
+
+	// ShaderFeature bits this material needs, combined with the geometry bits to pick a variant
+	virtual std::uint32_t shaderFeatures() const { return 0; }
 };
+
+// Materials of one model, created once per source material and shared by its primitives
+using MaterialTable = std::vector<std::unique_ptr<Material>>;
@@ -10,5 +10,11 @@ public:
 	Texture* diffuseMap = nullptr;
 	Texture* overlayMap = nullptr;
 
+	// Discard fragments below the cutoff (glTF MASK and BLEND materials)
+	bool alphaTest = false;
+	float alphaCutoff = 0.05f;
+
 	void bind(Shader& shader) const override;
+	std::uint32_t textureSetId() const override;
+	std::uint32_t shaderFeatures() const override;
 };
@@ -1,6 +1,31 @@
 #include "include_5568ke.hpp"
 
 #include "BlinnPhongMaterial.hpp"
+#include "GLStateCache.hpp"
+#include "ShaderLibrary.hpp"
+
+static UniformHandle const TEX0_UNIFORM = Shader::uniform("tex0");
+static UniformHandle const TEX1_UNIFORM = Shader::uniform("tex1");
+static UniformHandle const ALPHA_CUTOFF_UNIFORM = Shader::uniform("alphaCutoff");
+
+std::uint32_t BlinnPhongMaterial::textureSetId() const
+{
+	std::uint32_t diffuse = diffuseMap ? diffuseMap->id : 0;
+	std::uint32_t overlay = overlayMap ? overlayMap->id : 0;
+	return diffuse | (overlay << 16);
+}
+
+std::uint32_t BlinnPhongMaterial::shaderFeatures() const
+{
+	std::uint32_t features = 0;
+	if (diffuseMap)
+		features |= ShaderFeature::HAS_BASE_MAP;
+	if (overlayMap)
+		features |= ShaderFeature::HAS_OVERLAY;
+	if (alphaTest)
+		features |= ShaderFeature::ALPHA_TEST;
+	return features;
+}
 
 void BlinnPhongMaterial::bind(Shader& shader) const
 {
@@ -9,37 +34,16 @@ void BlinnPhongMaterial::bind(Shader& shader) const
 
 	// Bind diffuse/base texture to texture unit 0
 	if (diffuseMap) {
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, diffuseMap->id);
-		shader.setInt("tex0", 0);
+		GLStateCache::getInstance().bindTexture(0, GL_TEXTURE_2D, diffuseMap->id);
+		shader.setInt(TEX0_UNIFORM, 0);
 	}
 
 	// Bind overlay texture to texture unit 1
 	if (overlayMap) {
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, overlayMap->id);
-		shader.setInt("tex1", 1);
+		GLStateCache::getInstance().bindTexture(1, GL_TEXTURE_2D, overlayMap->id);
+		shader.setInt(TEX1_UNIFORM, 1);
 	}
 
-	// If no textures are available, we could potentially add a fallback
-	// by modifying the shader to use a uniform color, but that would require
-	// shader changes. For now, we'll just make sure at least one texture is bound.
-
-	if (!diffuseMap && !overlayMap) {
-		// Create a small white texture as fallback
-		static GLuint defaultTexture = 0;
-		if (defaultTexture == 0) {
-			// Create a default white texture
-			unsigned char whitePixel[4] = {255, 255, 255, 255};
-			glGenTextures(1, &defaultTexture);
-			glBindTexture(GL_TEXTURE_2D, defaultTexture);
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, whitePixel);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-		}
-
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, defaultTexture);
-		shader.setInt("tex0", 0);
-	}
-}
\ No newline at end of file
+	if (alphaTest)
+		shader.setFloat(ALPHA_CUTOFF_UNIFORM, alphaCutoff);
+}
@@ -2,9 +2,11 @@
 
 #include <glm/gtc/matrix_transform.hpp>
 #include <algorithm>
+#include <chrono>
 #include <filesystem>
 #include <iostream>
 
+#include "BlinnPhongMaterial.hpp"
 #include "GltfLoader.hpp"
 #include "Model.hpp"
 #include "Scene.hpp"
@@ -47,22 +49,176 @@ Model* ModelRegistry::loadModel(std::string const& path, std::string const& name
 		return nullptr;
 	}
 
-	if (model) {
-		// Store default transform parameters on the model
-		model->defaultScale = scale;
-		model->defaultRotation = rotation;
-		model->defaultTranslation = position;
+	if (model)
+		return registerModel_(modelName, std::unique_ptr<Model>(model), position, rotation, scale);
 
-		// Cache the model
-		auto result = model;
-		modelCache_[modelName] = std::unique_ptr<Model>(model);
+	std::cerr << "[ModelRegistry ERROR] Failed to load model '" << path << "'" << std::endl;
+	return nullptr;
+}
+
+ModelLoadHandle ModelRegistry::loadModelAsync(std::string const& path, std::string const& name, glm::vec3 position, glm::vec3 rotation, float scale,
+																							std::function<void(Model*)> onReady)
+{
+	auto status = std::make_shared<ModelLoadStatus>();
+	status->name = name.empty() ? std::filesystem::path(path).stem().string() : name;
+	status->path = path;
+
+	auto it = modelCache_.find(status->name);
+	if (it != modelCache_.end()) {
+		status->state = ModelLoadState::Ready;
+		status->model = it->second.get();
+		status->progress = 1.0f;
+		if (onReady)
+			onReady(status->model);
+		return status;
+	}
 
-		std::cout << "[ModelRegistry] Successfully loaded model '" << modelName << "'" << std::endl;
-		return result;
+	// Already on its way: wait for that load instead of importing and uploading the file again
+	for (PendingLoad& load : pendingLoads_) {
+		if (load.status->name == status->name) {
+			if (onReady)
+				load.onReady.push_back(std::move(onReady));
+			return load.status;
+		}
 	}
 
-	std::cerr << "[ModelRegistry ERROR] Failed to load model '" << path << "'" << std::endl;
-	return nullptr;
+	if (detectFormat_(path) != ModelFormat::GLTF) {
+		std::cerr << "[ModelRegistry ERROR] Unsupported model format" << std::endl;
+		status->state = ModelLoadState::Failed;
+		if (onReady)
+			onReady(nullptr);
+		return status;
+	}
+
+	// The import gets its own loader, so concurrent loads share no state
+	PendingLoad load;
+	load.status = status;
+	load.importing = std::async(std::launch::async, [loader = *gltfLoader_, path]() mutable { return loader.importModel(path); });
+	load.position = position;
+	load.rotation = rotation;
+	load.scale = scale;
+	if (onReady)
+		load.onReady.push_back(std::move(onReady));
+	pendingLoads_.push_back(std::move(load));
+
+	std::cout << "[ModelRegistry] Loading model '" << status->name << "' in the background" << std::endl;
+	return status;
+}
+
+void ModelRegistry::update(double uploadBudgetMs)
+{
+	auto const start = std::chrono::steady_clock::now();
+
+	for (size_t i = 0; i < pendingLoads_.size();) {
+		PendingLoad& load = pendingLoads_[i];
+		std::shared_ptr<ModelLoadStatus> const status = load.status;
+
+		if (status->state == ModelLoadState::Importing) {
+			if (load.importing.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+				i++;
+				continue;
+			}
+
+			try {
+				load.import = load.importing.get();
+			} catch (std::exception const& error) {
+				std::cerr << "[ModelRegistry ERROR] " << error.what() << std::endl;
+			}
+			status->state = load.import ? ModelLoadState::Uploading : ModelLoadState::Failed;
+		}
+
+		if (status->state == ModelLoadState::Uploading) {
+			// Whatever earlier loads left of this frame's budget
+			double const remaining = uploadBudgetMs - std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			if (remaining <= 0.0) {
+				i++;
+				continue;
+			}
+
+			bool const uploaded = GltfLoader::uploadModel(*load.import, remaining);
+			size_t const steps = load.import->uploadSteps();
+			status->progress = steps > 0 ? static_cast<float>(load.import->uploadedSteps()) / static_cast<float>(steps) : 1.0f;
+			if (!uploaded) {
+				i++;
+				continue;
+			}
+
+			status->model = registerModel_(status->name, std::move(load.import->model), load.position, load.rotation, load.scale);
+			status->state = ModelLoadState::Ready;
+		}
+
+		if (status->state == ModelLoadState::Failed)
+			std::cerr << "[ModelRegistry ERROR] Failed to load model '" << status->path << "'" << std::endl;
+
+		// Finished; the callbacks may start new loads, so drop the entry before running them
+		std::vector<std::function<void(Model*)>> onReady = std::move(load.onReady);
+		pendingLoads_.erase(pendingLoads_.begin() + static_cast<std::ptrdiff_t>(i));
+		for (auto const& callback : onReady)
+			callback(status->model);
+	}
+}
+
+Model* ModelRegistry::registerModel_(std::string const& name, std::unique_ptr<Model> model, glm::vec3 position, glm::vec3 rotation, float scale)
+{
+	auto it = modelCache_.find(name);
+	if (it != modelCache_.end())
+		return it->second.get();
+
+	// Store default transform parameters on the model
+	model->defaultScale = scale;
+	model->defaultRotation = rotation;
+	model->defaultTranslation = position;
+
+	// Cache the model
+	Model* result = model.get();
+	modelCache_[name] = std::move(model);
+
+	std::cout << "[ModelRegistry] Successfully loaded model '" << name << "'" << std::endl;
+	return result;
+}
+
+Model* ModelRegistry::placeholderModel()
+{
+	if (placeholder_)
+		return placeholder_.get();
+
+	// Unit cube with one set of vertices per face for flat normals
+	Mesh cube;
+	for (int axis = 0; axis < 3; axis++) {
+		for (float sign : {-1.0f, 1.0f}) {
+			glm::vec3 normal(0.0f);
+			normal[axis] = sign;
+			glm::vec3 const u = axis == 0 ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+			glm::vec3 const v = glm::cross(normal, u);
+
+			unsigned const base = static_cast<unsigned>(cube.vertices.size());
+			glm::vec2 const corners[4] = {{-1.0f, -1.0f}, {1.0f, -1.0f}, {1.0f, 1.0f}, {-1.0f, 1.0f}};
+			for (glm::vec2 const& corner : corners) {
+				Vertex vertex{};
+				vertex.position = 0.5f * (normal + corner.x * u + corner.y * v);
+				vertex.normal = normal;
+				vertex.texcoord = (corner + glm::vec2(1.0f)) * 0.5f;
+				cube.vertices.push_back(vertex);
+			}
+			for (unsigned index : {0u, 1u, 2u, 0u, 2u, 3u})
+				cube.indices.push_back(base + index);
+		}
+	}
+
+	Primitive primitive;
+	primitive.indexOffset = 0;
+	primitive.indexCount = static_cast<unsigned>(cube.indices.size());
+	primitive.material = 0;
+	cube.primitives.push_back(primitive);
+	cube.setup();
+
+	placeholder_ = std::make_unique<Model>();
+	placeholder_->name = "placeholder";
+	placeholder_->materials.push_back(std::make_unique<BlinnPhongMaterial>());
+	placeholder_->boundingBoxes.push_back(BoundingBox{glm::vec3(-0.5f), glm::vec3(0.5f)});
+	placeholder_->globalBoundingBox = placeholder_->boundingBoxes.front();
+	placeholder_->meshes.push_back(std::move(cube));
+	return placeholder_.get();
 }
 
 // Get a previously loaded model by name
@@ -146,13 +302,19 @@ void ModelRegistry::addModelToSceneCentered(Scene& scene, Model* model, std::str
 		return;
 	}
 
+	// Add to scene
+	addModelToScene(scene, model, name, centeredTransform(*model, position, rotation, scale));
+}
+
+glm::mat4 ModelRegistry::centeredTransform(Model const& model, glm::vec3 position, glm::vec3 rotation, float scale)
+{
 	// Calculate model center based on bounding box
-	glm::vec3 center = (model->globalBoundingBox.min + model->globalBoundingBox.max) * 0.5f;
+	glm::vec3 center = (model.globalBoundingBox.min + model.globalBoundingBox.max) * 0.5f;
 
 	// Calculate appropriate scale factor if needed
 	float scaleFactor = scale;
 	if (scale <= 0.0f) {
-		glm::vec3 size = model->globalBoundingBox.max - model->globalBoundingBox.min;
+		glm::vec3 size = model.globalBoundingBox.max - model.globalBoundingBox.min;
 		float maxDim = std::max(std::max(size.x, size.y), size.z);
 		scaleFactor = 1.5f / maxDim;
 	}
@@ -172,10 +334,7 @@ void ModelRegistry::addModelToSceneCentered(Scene& scene, Model* model, std::str
 	transform = glm::rotate(transform, rotation.z, glm::vec3(0.0f, 0.0f, 1.0f));
 
 	// Apply final position
-	transform = glm::translate(glm::mat4(1.0f), position) * transform;
-
-	// Add to scene
-	addModelToScene(scene, model, name, transform);
+	return glm::translate(glm::mat4(1.0f), position) * transform;
 }
 
 // Remove a model from a scene
@@ -192,6 +351,9 @@ std::vector<std::string> const& ModelRegistry::getRegisteredModels() const { ret
 // Clean up all models
 void ModelRegistry::cleanup()
 {
+	// Waits for imports still running on their threads
+	pendingLoads_.clear();
+	placeholder_.reset();
 	modelCache_.clear();
 	registeredModels_.clear();
 }
@@ -206,6 +368,8 @@ void ModelRegistry::setFormatDefaults(ModelFormat format, float scale, glm::vec3
 	formatDefaults_[format] = defaults;
 }
 
+void ModelRegistry::setAnimationCompression(AnimationCompressionSettings const& settings) { gltfLoader_->setAnimationCompression(settings); }
+
 // Private method to detect format from file extension
 ModelFormat ModelRegistry::detectFormat_(std::string const& path)
 {
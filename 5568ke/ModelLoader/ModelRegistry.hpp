@@ -1,6 +1,8 @@
 #pragma once
 
 #include <glm/glm.hpp>
+#include <functional>
+#include <future>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -10,6 +12,8 @@
 class Model;
 class Scene;
 class GltfLoader;
+struct AnimationCompressionSettings;
+struct ModelImport;
 
 // Enum for supported model formats
 enum class ModelFormat {
@@ -19,6 +23,21 @@ enum class ModelFormat {
 	AUTO_DETECT // Automatically detect format from file extension
 };
 
+enum class ModelLoadState { Importing, Uploading, Ready, Failed };
+
+// Progress of one loadModelAsync request, updated by ModelRegistry::update on the main thread
+struct ModelLoadStatus {
+	std::string name;
+	std::string path;
+	ModelLoadState state = ModelLoadState::Importing;
+	Model* model = nullptr; // set once Ready
+	float progress = 0.0f;	// fraction of GL uploads done
+
+	bool finished() const { return state == ModelLoadState::Ready || state == ModelLoadState::Failed; }
+};
+
+using ModelLoadHandle = std::shared_ptr<ModelLoadStatus const>;
+
 // Central registry for managing all model loaders and models in the application
 class ModelRegistry {
 public:
@@ -28,6 +47,23 @@ public:
 	Model* loadModel(std::string const& path, std::string const& name = "", glm::vec3 position = glm::vec3(0.0f), glm::vec3 rotation = glm::vec3(0.0f),
 									 float scale = 1.0f);
 
+	// Load a model without blocking: the file is parsed and its images decoded on a background
+	// thread, then update() creates its GL buffers and textures a few at a time, registers it and
+	// calls onReady with the model (nullptr on failure). onReady runs right away if the name is
+	// already loaded; a request for a name that is still loading joins that load.
+	ModelLoadHandle loadModelAsync(std::string const& path, std::string const& name = "", glm::vec3 position = glm::vec3(0.0f),
+																 glm::vec3 rotation = glm::vec3(0.0f), float scale = 1.0f, std::function<void(Model*)> onReady = {});
+
+	// Advance async loads, spending at most about uploadBudgetMs on GL uploads. Call once per frame on the GL thread.
+	void update(double uploadBudgetMs);
+	size_t pendingLoads() const { return pendingLoads_.size(); }
+
+	// Shared unit cube shown in place of models that are still loading (GL thread)
+	Model* placeholderModel();
+
+	// Transform that centers the model's bounds at `position`; scale <= 0 fits it into 1.5 units
+	static glm::mat4 centeredTransform(Model const& model, glm::vec3 position, glm::vec3 rotation, float scale);
+
 	// Get a previously loaded model by name
 	Model* getModel(std::string const& name);
 
@@ -56,6 +92,9 @@ public:
 	// Set format defaults (to be applied to newly loaded models)
 	void setFormatDefaults(ModelFormat format, float scale = 1.0f, glm::vec3 rotation = glm::vec3(0.0f), glm::vec3 translation = glm::vec3(0.0f));
 
+	// Clip compression settings for models loaded from now on
+	void setAnimationCompression(AnimationCompressionSettings const& settings);
+
 private:
 	ModelRegistry();
 	~ModelRegistry();
@@ -63,9 +102,26 @@ private:
 	// Detect format from file extension
 	ModelFormat detectFormat_(std::string const& path);
 
+	// Apply the default transform parameters and take ownership; keeps an already cached model of the same name
+	Model* registerModel_(std::string const& name, std::unique_ptr<Model> model, glm::vec3 position, glm::vec3 rotation, float scale);
+
 	// Cache of loaded models
 	std::unordered_map<std::string, std::unique_ptr<Model>> modelCache_;
 
+	// Async loads still importing or uploading
+	struct PendingLoad {
+		std::shared_ptr<ModelLoadStatus> status;
+		std::future<std::unique_ptr<ModelImport>> importing;
+		std::unique_ptr<ModelImport> import;
+		glm::vec3 position{0.0f};
+		glm::vec3 rotation{0.0f};
+		float scale = 1.0f;
+		std::vector<std::function<void(Model*)>> onReady; // one per request for this name
+	};
+	std::vector<PendingLoad> pendingLoads_;
+
+	std::unique_ptr<Model> placeholder_;
+
 	// List of registered model names (for UI reference)
 	std::vector<std::string> registeredModels_;
 
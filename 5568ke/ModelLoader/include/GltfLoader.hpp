@@ -3,12 +3,15 @@
 #include "include_5568ke.hpp"
 
 #include <glm/glm.hpp>
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 
 #include "Animation.hpp"
+#include "AnimationCompression.hpp"
 #include "BoundingBox.hpp"
 #include "Material.hpp"
 #include "Mesh.hpp"
@@ -19,15 +22,68 @@
 // Material type enum
 enum class MaterialType { BlinnPhong, PBR };
 
+// Decoded image waiting for its GL texture
+struct TextureUpload {
+	Texture* texture = nullptr;
+	int width = 0;
+	int height = 0;
+	int component = 4;
+	int pixelType = TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
+	std::shared_ptr<std::vector<unsigned char> const> pixels; // shared by every texture of the same image
+
+	// Sampler state, GL enums as stored in glTF
+	int wrapS = GL_REPEAT;
+	int wrapT = GL_REPEAT;
+	int minFilter = GL_LINEAR_MIPMAP_LINEAR;
+	int magFilter = GL_LINEAR;
+};
+
+// Decode time of one glTF image, for the load report
+struct ImageDecodeTime {
+	std::string name;
+	int width = 0;
+	int height = 0;
+	double ms = 0.0;
+};
+
+// A model parsed and decoded on the CPU whose GL buffers and textures are not created yet
+struct ModelImport {
+	std::string path;
+	std::unique_ptr<Model> model;
+
+	// Only textures the TextureCache did not hold yet are uploaded
+	std::vector<TextureUpload> textures;
+	std::vector<Texture*> acquiredTextures;
+
+	// Images decode concurrently, so the wall time is less than the sum of the per-image times
+	std::vector<ImageDecodeTime> imageDecodeTimes;
+	double imageDecodeMs = 0.0;
+
+	size_t uploadedTextures = 0;
+	size_t uploadedMeshes = 0;
+
+	size_t uploadSteps() const { return textures.size() + (model ? model->meshes.size() : 0); }
+	size_t uploadedSteps() const { return uploadedTextures + uploadedMeshes; }
+	bool uploaded() const { return uploadedSteps() == uploadSteps(); }
+};
+
 // Simplified GLTF model loader
 class GltfLoader {
 public:
 	GltfLoader() = default;
 	~GltfLoader() = default;
 
-	// Main loading method
+	// Main loading method: import and upload in one go (GL thread only)
 	Model* loadModel(std::string const& path);
 
+	// Parse the file, decode its images and build meshes, skeleton and clips without any GL call,
+	// so it can run on a worker thread. One import at a time per loader instance.
+	std::unique_ptr<ModelImport> importModel(std::string const& path);
+
+	// Create the pending GL textures and mesh buffers of `import` until `budgetMs` is spent (at least
+	// one step runs). GL thread only; returns true once everything is uploaded.
+	static bool uploadModel(ModelImport& import, double budgetMs);
+
 	// Helper methods for model transformation
 	static glm::vec3 calculateModelCenter(Model* model);
 	static float calculateModelScale(Model* model, float targetSize = 1.0f);
@@ -38,25 +94,33 @@ public:
 	// Apply positioning to a model
 	static void positionModel(Model* model, glm::vec3 position = glm::vec3(0.0f), glm::vec3 rotation = glm::vec3(0.0f), float scale = 1.0f);
 
+	// Error bounds for the clip compression run on import (disable to keep the raw keys)
+	void setAnimationCompression(AnimationCompressionSettings const& settings) { compressionSettings_ = settings; }
+	AnimationCompressionSettings const& getAnimationCompression() const { return compressionSettings_; }
+
 private:
 	// Main GLTF loading implementation
 	Model* loadGltf(std::string const& path, MaterialType type = MaterialType::BlinnPhong);
 
 	// Helper methods
+	void decodeImages(tinygltf::Model& model, std::vector<std::vector<unsigned char>>& encoded);
 	Texture* loadTexture(tinygltf::Model& model, int textureIndex, TextureType type);
-	Material* createMaterial(tinygltf::Model& model, tinygltf::Primitive& primitive, MaterialType type);
-	void processMesh(tinygltf::Model& model, tinygltf::Mesh& mesh, Mesh& outMesh, MaterialType materialType);
+	static void uploadTexture(TextureUpload& upload);
+	Material* createMaterial(tinygltf::Model& model, int materialIndex, MaterialType type);
+	std::uint16_t materialSlot(tinygltf::Model& model, int materialIndex, Model& outModel, MaterialType type);
+	void processMesh(tinygltf::Model& model, tinygltf::Mesh& mesh, Mesh& outMesh, Model& outModel, MaterialType materialType);
 
 	// Animation loading methods
+	// Only skins[0] becomes the skeleton; other skins are ignored with a warning (single palette per model)
 	void loadSkeleton(tinygltf::Model& model, Model* outModel);
 	void loadBones(tinygltf::Model& model, Model* outModel);
 	void loadAnimations(tinygltf::Model& model, Model* outModel);
-	void processNode(tinygltf::Model& model, int nodeIndex, SkeletonNode* parent, SkeletonNode* outNode,
-									 std::unordered_map<std::string, SkeletonNode*>& nodeMap); // Changed from vector to unordered_map
+	void buildHierarchy(tinygltf::Model& model, tinygltf::Skin const& skin, Skeleton& skeleton);
+	void processNode(tinygltf::Model& model, int nodeIndex, int parent, tinygltf::Skin const& skin, Skeleton& skeleton);
 	void processSkin(tinygltf::Model& model, int skinIndex, Skeleton& skeleton);
 	void processAnimation(tinygltf::Model& model, int animIndex, Model* outModel);
 	void extractKeyframes(tinygltf::Model& model, tinygltf::Animation const& anim, // Changed to const reference
-												int channelIndex, Bone& bone);
+												int channelIndex, BoneTrack& track);
 	void applyVertexBoneData(tinygltf::Model& model, int meshIndex, Mesh& outMesh, Skeleton& skeleton);
 
 	// Conversion helpers
@@ -67,4 +131,15 @@ private:
 	// Bounding box calculations
 	BoundingBox calculateBoundingBox(Mesh const& mesh);
 	BoundingBox calculateGlobalBoundingBox(std::vector<BoundingBox> const& boundingBoxes);
+
+	AnimationCompressionSettings compressionSettings_;
+
+	// Import in progress, receives the staged texture uploads
+	ModelImport* import_ = nullptr;
+
+	// Material table slot of each glTF material of the current file, the last one for primitives without material
+	std::vector<std::uint16_t> materialSlots_;
+
+	// Decoded images of the current file moved out of tinygltf, by image index
+	std::unordered_map<int, std::shared_ptr<std::vector<unsigned char> const>> stagedImages_;
 };
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/quaternion.hpp>
 #include <algorithm>
+#include <chrono>
 #include <filesystem>
 #include <iostream>
 #include <limits>
@@ -13,12 +14,108 @@
 
 #include "BlinnPhongMaterial.hpp"
 #include "BoundingBox.hpp"
+#include "GLStateCache.hpp"
+#include "JobSystem.hpp"
 #include "Mesh.hpp"
 #include "Model.hpp"
 #include "Texture.hpp"
+#include "TextureCache.hpp"
+
+namespace {
+// Index of a node within the skin's joint list, i.e. its bone index, or -1
+int findJoint(tinygltf::Skin const& skin, int nodeIndex)
+{
+	auto it = std::find(skin.joints.begin(), skin.joints.end(), nodeIndex);
+	return it != skin.joints.end() ? static_cast<int>(it - skin.joints.begin()) : -1;
+}
+
+// Image loader installed into tinygltf: keep the encoded bytes and decode them later, all images at once
+bool captureImage(tinygltf::Image*, int const imageIndex, std::string*, std::string*, int, int, unsigned char const* bytes, int size, void* userData)
+{
+	auto& encoded = *static_cast<std::vector<std::vector<unsigned char>>*>(userData);
+	if (encoded.size() <= static_cast<size_t>(imageIndex))
+		encoded.resize(imageIndex + 1);
+	encoded[imageIndex].assign(bytes, bytes + size);
+	return true;
+}
+
+// Same output as tinygltf's stb_image loader: four channels, 16 bits per channel if the file has them
+bool decodeImage(std::vector<unsigned char> const& bytes, tinygltf::Image& image)
+{
+	int const size = static_cast<int>(bytes.size());
+	int width = 0, height = 0, component = 0;
+	int bits = 8;
+
+	unsigned char* data = nullptr;
+	if (stbi_is_16_bit_from_memory(bytes.data(), size)) {
+		data = reinterpret_cast<unsigned char*>(stbi_load_16_from_memory(bytes.data(), size, &width, &height, &component, 4));
+		if (data)
+			bits = 16;
+	}
+	if (!data)
+		data = stbi_load_from_memory(bytes.data(), size, &width, &height, &component, 4);
+	if (!data)
+		return false;
+
+	image.width = width;
+	image.height = height;
+	image.component = 4;
+	image.bits = bits;
+	image.pixel_type = bits == 16 ? TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT : TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
+	image.image.assign(data, data + static_cast<size_t>(width) * height * 4 * (bits / 8));
+	stbi_image_free(data);
+	return true;
+}
+} // namespace
 
 // Main method to load a GLTF model
-Model* GltfLoader::loadModel(std::string const& path) { return loadGltf(path, MaterialType::BlinnPhong); }
+Model* GltfLoader::loadModel(std::string const& path)
+{
+	std::unique_ptr<ModelImport> import = importModel(path);
+	if (!import)
+		return nullptr;
+
+	uploadModel(*import, std::numeric_limits<double>::infinity());
+	return import->model.release();
+}
+
+std::unique_ptr<ModelImport> GltfLoader::importModel(std::string const& path)
+{
+	auto import = std::make_unique<ModelImport>();
+	import->path = path;
+	import_ = import.get();
+	import->model.reset(loadGltf(path, MaterialType::BlinnPhong));
+	import_ = nullptr;
+	stagedImages_.clear();
+
+	if (!import->model) {
+		// Nothing was uploaded through these references, dropping them deletes no GL object
+		for (Texture* texture : import->acquiredTextures)
+			TextureCache::getInstance().release(texture);
+		return nullptr;
+	}
+
+	// The model owns the cache references from now on
+	import->model->textures = std::move(import->acquiredTextures);
+	return import;
+}
+
+bool GltfLoader::uploadModel(ModelImport& import, double budgetMs)
+{
+	auto const start = std::chrono::steady_clock::now();
+
+	// Textures first, then one mesh per step; a step is never split, so at least one always runs
+	while (!import.uploaded()) {
+		if (import.uploadedTextures < import.textures.size())
+			uploadTexture(import.textures[import.uploadedTextures++]);
+		else
+			import.model->meshes[import.uploadedMeshes++].setup();
+
+		if (std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() >= budgetMs)
+			break;
+	}
+	return import.uploaded();
+}
 
 // Calculate the center point of a model based on its bounding box
 glm::vec3 GltfLoader::calculateModelCenter(Model* model)
@@ -97,6 +194,10 @@ Model* GltfLoader::loadGltf(std::string const& path, MaterialType type)
 	// Enable verbose debug output
 	loader.SetStoreOriginalJSONForExtrasAndExtensions(true);
 
+	// Parsing only collects the encoded images; decoding them one after another dominated load times
+	std::vector<std::vector<unsigned char>> encodedImages;
+	loader.SetImageLoader(captureImage, &encodedImages);
+
 	bool ret;
 	// Determine file type (GLTF or GLB) and load accordingly
 	if (path.find(".glb") != std::string::npos) {
@@ -121,6 +222,8 @@ Model* GltfLoader::loadGltf(std::string const& path, MaterialType type)
 		return nullptr;
 	}
 
+	decodeImages(gltfModel, encodedImages);
+
 	// Create and populate model
 	Model* model = new Model();
 	model->filePath = path;
@@ -133,24 +236,25 @@ Model* GltfLoader::loadGltf(std::string const& path, MaterialType type)
 	// Initialize skeleton if model has skins
 	if (!gltfModel.skins.empty()) {
 		model->hasAnimations = true;
-		model->skeleton.initBoneMatrices();
 		loadSkeleton(gltfModel, model);
 	}
 
+	// Materials are created when a primitive first uses them
+	stagedImages_.clear();
+	materialSlots_.assign(gltfModel.materials.size() + 1, Primitive::NO_MATERIAL);
+
 	// Process all meshes in the GLTF file
 	for (size_t i = 0; i < gltfModel.meshes.size(); i++) {
 		tinygltf::Mesh& mesh = gltfModel.meshes[i];
 		Mesh outMesh;
-		processMesh(gltfModel, mesh, outMesh, type);
+		processMesh(gltfModel, mesh, outMesh, *model, type);
 
 		// Apply bone weights to vertices if model has animations
 		if (model->hasAnimations) {
 			applyVertexBoneData(gltfModel, i, outMesh, model->skeleton);
 		}
 
-		// Setup OpenGL buffers and VAO
-		outMesh.setup();
-
+		// GL buffers and the VAO are created later by uploadModel
 		// Calculate bounding box
 		BoundingBox bbox = calculateBoundingBox(outMesh);
 		model->boundingBoxes.push_back(bbox);
@@ -169,47 +273,130 @@ Model* GltfLoader::loadGltf(std::string const& path, MaterialType type)
 							<< model->globalBoundingBox.max.z << ")" << std::endl;
 	}
 
+	// Per-bone bounds let the renderer cull skinned entities by their current pose
+	if (model->hasAnimations)
+		model->calculateBoneBoundingBoxes();
+
 	// Load animations if available
 	if (model->hasAnimations && !gltfModel.animations.empty()) {
 		loadAnimations(gltfModel, model);
+	}
 
-		// Initialize animation player
-		model->animationPlayer.initialize(model);
+	return model;
+}
 
-		// Start playing the first animation by default
-		if (!model->animations.empty()) {
-			model->animationPlayer.setAnimation(0);
-			model->animationPlayer.play();
+// Decode the captured images concurrently on the job system, timing each one. Images that fail
+// stay empty and their textures are skipped, like external images tinygltf could not read.
+void GltfLoader::decodeImages(tinygltf::Model& model, std::vector<std::vector<unsigned char>>& encoded)
+{
+	size_t const count = model.images.size();
+	encoded.resize(count);
+
+	std::vector<double> times(count, 0.0);
+	std::vector<char> decoded(count, 0);
+
+	// Usually called on a loader thread: the workers and this thread run the decodes, while the main
+	// thread waiting on its own parallelFor never picks one up (see JobSystem::findHelpJob_)
+	auto const start = std::chrono::steady_clock::now();
+	JobSystem::getInstance().parallelFor(count, 1, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			auto const imageStart = std::chrono::steady_clock::now();
+			decoded[i] = !encoded[i].empty() && decodeImage(encoded[i], model.images[i]);
+			times[i] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - imageStart).count();
+			std::vector<unsigned char>().swap(encoded[i]);
 		}
+	});
+	double const wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	double workMs = 0.0;
+	for (size_t i = 0; i < count; i++) {
+		tinygltf::Image const& image = model.images[i];
+		std::string const name = image.uri.empty() ? "image " + std::to_string(i) : image.uri;
+		if (!decoded[i]) {
+			std::cerr << "[GltfLoader]  Failed to decode image '" << name << "'" << std::endl;
+			continue;
+		}
+
+		std::cout << "[GltfLoader]  Decoded '" << name << "' (" << image.width << "x" << image.height << ") in " << times[i] << " ms" << std::endl;
+		workMs += times[i];
+		if (import_)
+			import_->imageDecodeTimes.push_back(ImageDecodeTime{name, image.width, image.height, times[i]});
 	}
 
-	return model;
+	if (count > 0)
+		std::cout << "[GltfLoader]  Decoded " << count << " images in " << wallMs << " ms (" << workMs << " ms of decoding)" << std::endl;
+	if (import_)
+		import_->imageDecodeMs = wallMs;
 }
 
-// Load texture from GLTF model
+// Load texture from GLTF model; the pixels are staged in the current import and uploaded later
 Texture* GltfLoader::loadTexture(tinygltf::Model& model, int textureIndex, TextureType type)
 {
-	if (textureIndex < 0)
+	if (textureIndex < 0 || !import_)
 		return nullptr;
 
-	auto* texture = new Texture();
-	texture->type = type;
-
+	// Images that failed to decode get no texture (decodeImage only sets the size on success)
 	tinygltf::Texture const& gltfTexture = model.textures[textureIndex];
-	tinygltf::Image const& image = model.images[gltfTexture.source];
+	if (gltfTexture.source < 0 || model.images[gltfTexture.source].width <= 0)
+		return nullptr;
+	tinygltf::Image& image = model.images[gltfTexture.source];
 
-	// Save the path for debugging/reference
-	texture->path = image.uri;
+	bool needsUpload = false;
+	TextureCache::Key const key{import_->path, gltfTexture.source, gltfTexture.sampler};
+	Texture* texture = TextureCache::getInstance().acquire(key, type, image.uri, needsUpload);
+	import_->acquiredTextures.push_back(texture);
+	if (!needsUpload)
+		return texture;
+
+	// Every texture of this image (other samplers) shares one pixel buffer
+	auto& pixels = stagedImages_[gltfTexture.source];
+	if (!pixels)
+		pixels = std::make_shared<std::vector<unsigned char> const>(std::move(image.image));
+
+	std::cout << "[GltfLoader]  Loading texture: " << image.uri << " (" << image.width << "x" << image.height << ", components: " << image.component << ")"
+						<< std::endl;
+
+	TextureUpload upload;
+	upload.texture = texture;
+	upload.width = image.width;
+	upload.height = image.height;
+	upload.component = image.component;
+	upload.pixelType = image.pixel_type;
+	upload.pixels = pixels;
+
+	if (gltfTexture.sampler >= 0) {
+		tinygltf::Sampler const& sampler = model.samplers[gltfTexture.sampler];
+		upload.wrapS = sampler.wrapS;
+		upload.wrapT = sampler.wrapT;
+		if (sampler.minFilter >= 0)
+			upload.minFilter = sampler.minFilter;
+		if (sampler.magFilter >= 0)
+			upload.magFilter = sampler.magFilter;
+	}
+	import_->textures.push_back(std::move(upload));
+
+	return texture;
+}
+
+// Create the GL texture for staged pixels, then drop them
+void GltfLoader::uploadTexture(TextureUpload& upload)
+{
+	// Another import of the same file may have uploaded this shared texture first
+	Texture* texture = upload.texture;
+	if (texture->id != 0) {
+		upload.pixels.reset();
+		return;
+	}
 
 	glGenTextures(1, &texture->id);
-	glBindTexture(GL_TEXTURE_2D, texture->id);
+	GLStateCache::getInstance().bindTexture(0, GL_TEXTURE_2D, texture->id);
 
 	GLenum format, internalFormat;
-	if (image.component == 1) {
+	if (upload.component == 1) {
 		format = GL_RED;
 		internalFormat = GL_RED;
 	}
-	else if (image.component == 3) {
+	else if (upload.component == 3) {
 		format = GL_RGB;
 		internalFormat = GL_RGB;
 	}
@@ -220,38 +407,36 @@ Texture* GltfLoader::loadTexture(tinygltf::Model& model, int textureIndex, Textu
 
 	// Make sure the pixel type is correct
 	GLenum pixelType = GL_UNSIGNED_BYTE;
-	if (image.pixel_type == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT) {
+	if (upload.pixelType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT) {
 		pixelType = GL_UNSIGNED_SHORT;
 	}
-	else if (image.pixel_type == TINYGLTF_COMPONENT_TYPE_FLOAT) {
+	else if (upload.pixelType == TINYGLTF_COMPONENT_TYPE_FLOAT) {
 		pixelType = GL_FLOAT;
 	}
 
-	std::cout << "[GltfLoader]  Loading texture: " << image.uri << " (" << image.width << "x" << image.height << ", components: " << image.component << ")"
-						<< std::endl;
-
-	glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, image.width, image.height, 0, format, pixelType, image.image.data());
+	glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, upload.width, upload.height, 0, format, pixelType, upload.pixels->data());
 	glGenerateMipmap(GL_TEXTURE_2D);
 
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, upload.wrapS);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, upload.wrapT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, upload.minFilter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, upload.magFilter);
 
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLStateCache::getInstance().bindTexture(0, GL_TEXTURE_2D, 0);
 
-	return texture;
+	TextureCache::getInstance().markUploaded(texture);
+	upload.pixels.reset();
 }
 
 // Create material from GLTF model
-Material* GltfLoader::createMaterial(tinygltf::Model& model, tinygltf::Primitive& primitive, MaterialType type)
+Material* GltfLoader::createMaterial(tinygltf::Model& model, int materialIndex, MaterialType type)
 {
 	if (type == MaterialType::BlinnPhong) {
 		auto* material = new BlinnPhongMaterial();
 
 		// Check if material exists
-		if (primitive.material >= 0) {
-			tinygltf::Material const& mat = model.materials[primitive.material];
+		if (materialIndex >= 0) {
+			tinygltf::Material const& mat = model.materials[materialIndex];
 
 			// Set base color
 			if (mat.pbrMetallicRoughness.baseColorFactor.size() >= 3) {
@@ -279,6 +464,15 @@ Material* GltfLoader::createMaterial(tinygltf::Model& model, tinygltf::Primitive
 				material->overlayMap = loadTexture(model, mat.normalTexture.index, TextureType::Normal);
 				std::cout << "[GltfLoader]  Loaded normal/overlay texture" << std::endl;
 			}
+
+			// Opaque materials ignore alpha; blending is not supported, so BLEND falls back to a low cutoff
+			if (mat.alphaMode == "MASK") {
+				material->alphaTest = true;
+				material->alphaCutoff = static_cast<float>(mat.alphaCutoff);
+			}
+			else if (mat.alphaMode == "BLEND") {
+				material->alphaTest = true;
+			}
 		}
 
 		return material;
@@ -288,8 +482,25 @@ Material* GltfLoader::createMaterial(tinygltf::Model& model, tinygltf::Primitive
 	return new BlinnPhongMaterial();
 }
 
+// Slot in the model's material table for a glTF material index (-1 for none), created on first use
+std::uint16_t GltfLoader::materialSlot(tinygltf::Model& model, int materialIndex, Model& outModel, MaterialType type)
+{
+	std::uint16_t& slot = materialSlots_[materialIndex >= 0 ? materialIndex : materialSlots_.size() - 1];
+	if (slot != Primitive::NO_MATERIAL)
+		return slot;
+
+	if (outModel.materials.size() >= Primitive::NO_MATERIAL) {
+		std::cerr << "[GltfLoader]  Too many materials, drawing the rest without one" << std::endl;
+		return Primitive::NO_MATERIAL;
+	}
+
+	slot = static_cast<std::uint16_t>(outModel.materials.size());
+	outModel.materials.emplace_back(createMaterial(model, materialIndex, type));
+	return slot;
+}
+
 // Process mesh data from GLTF model
-void GltfLoader::processMesh(tinygltf::Model& model, tinygltf::Mesh& mesh, Mesh& outMesh, MaterialType materialType)
+void GltfLoader::processMesh(tinygltf::Model& model, tinygltf::Mesh& mesh, Mesh& outMesh, Model& outModel, MaterialType materialType)
 {
 	// Process each primitive
 	for (tinygltf::Primitive& primitive : mesh.primitives) {
@@ -404,8 +615,8 @@ void GltfLoader::processMesh(tinygltf::Model& model, tinygltf::Mesh& mesh, Mesh&
 				}
 			}
 
-			// Create material for this primitive
-			outPrimitive.material = createMaterial(model, primitive, materialType);
+			// Primitives using the same glTF material share one instance
+			outPrimitive.material = materialSlot(model, primitive.material, outModel, materialType);
 			outMesh.primitives.push_back(outPrimitive);
 		}
 	}
@@ -471,6 +682,12 @@ void GltfLoader::loadSkeleton(tinygltf::Model& model, Model* outModel)
 		return;
 	}
 
+	// Only the first skin is flattened: joints of other skins are not bones and meshes bound to them
+	// index the wrong palette entries
+	if (model.skins.size() > 1)
+		std::cerr << "[GltfLoader] Warning: model has " << model.skins.size() << " skins, only the first one (" << model.skins[0].name
+							<< ") is loaded, joints of the others are not animated" << std::endl;
+
 	// Process the first skin
 	int skinIndex = 0;
 	processSkin(model, skinIndex, outModel->skeleton);
@@ -530,6 +747,55 @@ void GltfLoader::processSkin(tinygltf::Model& model, int skinIndex, Skeleton& sk
 	skeleton.boneCount = static_cast<int>(skeleton.bones.size());
 
 	std::cout << "[GltfLoader] Loaded " << skeleton.boneCount << " bones" << std::endl;
+
+	buildHierarchy(model, skin, skeleton);
+}
+
+void GltfLoader::buildHierarchy(tinygltf::Model& model, tinygltf::Skin const& skin, Skeleton& skeleton)
+{
+	skeleton.nodeParents.clear();
+	skeleton.nodeBones.clear();
+	skeleton.nodeRestTransforms.clear();
+
+	// Depth-first pre-order over the scene puts every parent before its children
+	if (!model.scenes.empty()) {
+		tinygltf::Scene const& scene = model.scenes[model.defaultScene >= 0 ? model.defaultScene : 0];
+		for (int root : scene.nodes)
+			processNode(model, root, -1, skin, skeleton);
+	}
+
+	// Keep only bones and their ancestors; walking backwards visits children before parents
+	size_t const nodeCount = skeleton.nodeCount();
+	std::vector<char> keep(nodeCount, 0);
+	for (size_t i = nodeCount; i-- > 0;) {
+		if (skeleton.nodeBones[i] >= 0)
+			keep[i] = 1;
+		if (keep[i] && skeleton.nodeParents[i] >= 0)
+			keep[skeleton.nodeParents[i]] = 1;
+	}
+
+	// Compact in place, parents keep preceding children so the remap is always ready
+	std::vector<int> remap(nodeCount, -1);
+	size_t kept = 0;
+	for (size_t i = 0; i < nodeCount; i++) {
+		if (!keep[i])
+			continue;
+
+		int const parent = skeleton.nodeParents[i];
+		remap[i] = static_cast<int>(kept);
+		skeleton.nodeParents[kept] = parent >= 0 ? remap[parent] : -1;
+		skeleton.nodeBones[kept] = skeleton.nodeBones[i];
+		skeleton.nodeRestTransforms[kept] = skeleton.nodeRestTransforms[i];
+		kept++;
+	}
+	skeleton.nodeParents.resize(kept);
+	skeleton.nodeBones.resize(kept);
+	skeleton.nodeRestTransforms.resize(kept);
+
+	// Rest pose for blending and chain heights for the animation LOD
+	skeleton.finalize();
+
+	std::cout << "[GltfLoader] Flattened skeleton hierarchy: " << kept << " of " << nodeCount << " nodes" << std::endl;
 }
 
 void GltfLoader::applyVertexBoneData(tinygltf::Model& model, int meshIndex, Mesh& outMesh, Skeleton& skeleton)
@@ -652,13 +918,16 @@ void GltfLoader::processAnimation(tinygltf::Model& model, int animIndex, Model*
 	tinygltf::Animation const& gltfAnim = model.animations[animIndex];
 
 	// Create a new animation
-	Animation animation;
+	AnimationClip animation;
 	animation.name = gltfAnim.name.empty() ? "animation_" + std::to_string(animIndex) : gltfAnim.name;
 
 	std::cout << "[GltfLoader] Processing animation: " << animation.name << std::endl;
 
-	// Set default ticks per second if not specified
-	animation.ticksPerSecond = 25.0f;
+	// glTF keyframe times are in seconds
+	animation.ticksPerSecond = 1.0f;
+
+	// Keys are stored per clip, so clips of the same skeleton no longer share (and concatenate) tracks
+	animation.tracks.resize(outModel->skeleton.bones.size());
 
 	// Process animation channels
 	for (size_t i = 0; i < gltfAnim.channels.size(); i++) {
@@ -669,57 +938,43 @@ void GltfLoader::processAnimation(tinygltf::Model& model, int animIndex, Model*
 			continue;
 		}
 
-		// Get the node name
-		tinygltf::Node const& targetNode = model.nodes[channel.target_node];
-		std::string nodeName = targetNode.name.empty() ? "node_" + std::to_string(channel.target_node) : targetNode.name;
-
-		// Find corresponding bone
-		int boneIndex = outModel->skeleton.getBoneIndex(nodeName);
+		// Find corresponding bone by node index (names may be missing or repeated)
+		int boneIndex = model.skins.empty() ? -1 : findJoint(model.skins[0], channel.target_node);
 		if (boneIndex < 0) {
 			continue;
 		}
 
 		// Extract keyframes for this channel
-		Bone& bone = outModel->skeleton.bones[boneIndex];
-		extractKeyframes(model, gltfAnim, i, bone);
+		BoneTrack& track = animation.tracks[boneIndex];
+		extractKeyframes(model, gltfAnim, i, track);
 
 		// Update animation duration to the max time of all keyframes
-		if (!bone.positions.empty()) {
-			animation.duration = std::max(animation.duration, bone.positions.back().timeStamp);
+		if (!track.positions.empty()) {
+			animation.duration = std::max(animation.duration, track.positions.back().timeStamp);
 		}
-		if (!bone.rotations.empty()) {
-			animation.duration = std::max(animation.duration, bone.rotations.back().timeStamp);
+		if (!track.rotations.empty()) {
+			animation.duration = std::max(animation.duration, track.rotations.back().timeStamp);
 		}
-		if (!bone.scales.empty()) {
-			animation.duration = std::max(animation.duration, bone.scales.back().timeStamp);
+		if (!track.scales.empty()) {
+			animation.duration = std::max(animation.duration, track.scales.back().timeStamp);
 		}
 	}
 
 	std::cout << "[GltfLoader] Animation duration: " << animation.duration << " ticks" << std::endl;
 
-	// Create animation hierarchy
-	animation.rootNode = new SkeletonNode();
-	animation.rootNode->name = "root";
-	animation.rootNode->transformation = glm::mat4(1.0f);
-	animation.nodeMap["root"] = animation.rootNode;
-
-	// Process scene nodes to build hierarchy
-	if (model.scenes.size() > 0) {
-		tinygltf::Scene const& scene = model.scenes[model.defaultScene >= 0 ? model.defaultScene : 0];
-
-		for (size_t i = 0; i < scene.nodes.size(); i++) {
-			SkeletonNode* node = new SkeletonNode();
-			processNode(model, scene.nodes[i], animation.rootNode, node, animation.nodeMap);
-			animation.rootNode->children.push_back(node);
+	if (compressionSettings_.enabled) {
+		ClipCompressionReport const report = compressClip(animation, outModel->skeleton, compressionSettings_);
+		if (report.compressed) {
+			std::cout << "[GltfLoader] Compressed clip '" << report.clip << "': " << report.rawBytes / 1024 << " KB -> " << report.compressedBytes / 1024 << " KB ("
+								<< report.ratio() << "x), keys " << report.rawKeys << " -> " << report.keptKeys << ", max joint error " << report.maxJointError << std::endl;
 		}
 	}
 
 	// Add animation to model
-	outModel->animations.push_back(animation);
+	outModel->animations.push_back(std::move(animation));
 }
 
-void GltfLoader::processNode(tinygltf::Model& model, int nodeIndex, SkeletonNode* parent, SkeletonNode* outNode,
-														 std::unordered_map<std::string, SkeletonNode*>& nodeMap)
+void GltfLoader::processNode(tinygltf::Model& model, int nodeIndex, int parent, tinygltf::Skin const& skin, Skeleton& skeleton)
 {
 	if (nodeIndex < 0 || nodeIndex >= static_cast<int>(model.nodes.size())) {
 		return;
@@ -727,13 +982,6 @@ void GltfLoader::processNode(tinygltf::Model& model, int nodeIndex, SkeletonNode
 
 	tinygltf::Node const& node = model.nodes[nodeIndex];
 
-	// Set node properties
-	outNode->name = node.name.empty() ? "node_" + std::to_string(nodeIndex) : node.name;
-
-	// Try to find corresponding bone
-	// You'll need to implement this based on your skeleton structure
-	outNode->boneIndex = -1; // Default to no bone
-
 	// Calculate transformation matrix
 	glm::mat4 transform = glm::mat4(1.0f);
 
@@ -763,20 +1011,19 @@ void GltfLoader::processNode(tinygltf::Model& model, int nodeIndex, SkeletonNode
 													node.matrix[8], node.matrix[9], node.matrix[10], node.matrix[11], node.matrix[12], node.matrix[13], node.matrix[14], node.matrix[15]);
 	}
 
-	outNode->transformation = transform;
-
-	// Add to node map
-	nodeMap[outNode->name] = outNode;
+	// Append this node, then its subtree
+	int const flatIndex = static_cast<int>(skeleton.nodeCount());
+	skeleton.nodeParents.push_back(parent);
+	skeleton.nodeBones.push_back(findJoint(skin, nodeIndex));
+	skeleton.nodeRestTransforms.push_back(transform);
 
 	// Process children
-	for (size_t i = 0; i < node.children.size(); i++) {
-		SkeletonNode* childNode = new SkeletonNode();
-		processNode(model, node.children[i], outNode, childNode, nodeMap);
-		outNode->children.push_back(childNode);
+	for (int child : node.children) {
+		processNode(model, child, flatIndex, skin, skeleton);
 	}
 }
 
-void GltfLoader::extractKeyframes(tinygltf::Model& model, tinygltf::Animation const& anim, int channelIndex, Bone& bone)
+void GltfLoader::extractKeyframes(tinygltf::Model& model, tinygltf::Animation const& anim, int channelIndex, BoneTrack& track)
 {
 	tinygltf::AnimationChannel const& channel = anim.channels[channelIndex];
 	tinygltf::AnimationSampler const& sampler = anim.samplers[channel.sampler];
@@ -798,15 +1045,17 @@ void GltfLoader::extractKeyframes(tinygltf::Model& model, tinygltf::Animation co
 	// Process keyframes based on target path
 	if (channel.target_path == "translation") {
 		// Position keyframes
+		track.positions.reserve(track.positions.size() + inputAccessor.count);
 		for (size_t i = 0; i < inputAccessor.count; i++) {
 			KeyPosition keyframe;
 			keyframe.timeStamp = times[i];
 			keyframe.position = glm::vec3(values[i * 3], values[i * 3 + 1], values[i * 3 + 2]);
-			bone.positions.push_back(keyframe);
+			track.positions.push_back(keyframe);
 		}
 	}
 	else if (channel.target_path == "rotation") {
 		// Rotation keyframes
+		track.rotations.reserve(track.rotations.size() + inputAccessor.count);
 		for (size_t i = 0; i < inputAccessor.count; i++) {
 			KeyRotation keyframe;
 			keyframe.timeStamp = times[i];
@@ -818,16 +1067,17 @@ void GltfLoader::extractKeyframes(tinygltf::Model& model, tinygltf::Animation co
 																			 values[i * 4 + 2]	// z
 			);
 
-			bone.rotations.push_back(keyframe);
+			track.rotations.push_back(keyframe);
 		}
 	}
 	else if (channel.target_path == "scale") {
 		// Scale keyframes
+		track.scales.reserve(track.scales.size() + inputAccessor.count);
 		for (size_t i = 0; i < inputAccessor.count; i++) {
 			KeyScale keyframe;
 			keyframe.timeStamp = times[i];
 			keyframe.scale = glm::vec3(values[i * 3], values[i * 3 + 1], values[i * 3 + 2]);
-			bone.scales.push_back(keyframe);
+			track.scales.push_back(keyframe);
 		}
 	}
 }
@@ -1,31 +1,62 @@
 #version 330 core
+
+// Variants are built by ShaderLibrary from the material's HAS_BASE_MAP, HAS_OVERLAY and ALPHA_TEST bits
+
 out vec4 FragColor;
 in VS_OUT{vec3 Pos;vec3 N;vec2 UV;} fs;
+
+#ifdef HAS_BASE_MAP
 uniform sampler2D tex0;   // base
+#endif
+#ifdef HAS_OVERLAY
 uniform sampler2D tex1;   // overlay, may be all‑transparent
-uniform vec3 lightPos, viewPos;
+#endif
+#ifdef ALPHA_TEST
+uniform float alphaCutoff;
+#endif
+
+// Written once per frame by Renderer::beginFrame (see UniformBlocks.hpp)
+layout(std140) uniform FrameData {
+    mat4 view;
+    mat4 proj;
+    vec4 viewPos;    // xyz
+    vec4 lightPos;   // xyz
+    vec4 lightColor; // rgb, a = intensity
+} frame;
 
 void main()
 {
-    // Sample textures
-    vec4 base = texture(tex0, fs.UV);
-    vec4 eye = texture(tex1, fs.UV);
-    
+    // Untextured materials are plain white
+    vec4 texColor = vec4(1.0);
+
+#ifdef HAS_BASE_MAP
+    texColor = texture(tex0, fs.UV);
+#endif
+
+#ifdef HAS_OVERLAY
     // Choose overlay if it contributes color, otherwise use base
-    vec4 texColor = eye.a > 0.05 ? eye : base;
-    
-    // If texture is completely transparent, discard the fragment
+    vec4 eye = texture(tex1, fs.UV);
+    texColor = eye.a > 0.05 ? eye : texColor;
+#endif
+
+#ifdef ALPHA_TEST
+    if (texColor.a < alphaCutoff) discard;
+#elif defined(HAS_BASE_MAP) || defined(HAS_OVERLAY)
+    // Fully transparent texels are cut out even for OPAQUE materials, the bundled assets rely on it
     if (texColor.a < 0.05) discard;
-    
+#endif
+
+#if defined(HAS_BASE_MAP) || defined(HAS_OVERLAY)
     // Check for completely black texture (possible missing texture)
     if (length(texColor.rgb) < 0.01) {
         texColor = vec4(0.7, 0.7, 0.7, 1.0); // Use light gray as fallback
     }
+#endif
     
     // Prepare lighting variables
     vec3 N = normalize(fs.N);
-    vec3 L = normalize(lightPos - fs.Pos);
-    vec3 V = normalize(viewPos - fs.Pos);
+    vec3 L = normalize(frame.lightPos.xyz - fs.Pos);
+    vec3 V = normalize(frame.viewPos.xyz - fs.Pos);
     vec3 H = normalize(L + V);
     
     // Calculate lighting components
@@ -38,4 +69,4 @@ void main()
     
     // Output final color
     FragColor = vec4(finalColor, 1.0);
-}
\ No newline at end of file
+}
@@ -1,16 +1,82 @@
 #version 330 core
 
+// Variants are built by ShaderLibrary, which defines SKINNED and INSTANCED as needed
+
 layout(location=0) in vec3 aPos;
 layout(location=1) in vec3 aNormal;
 layout(location=2) in vec2 aUV;
 
-uniform mat4 model,view,proj;
+#ifdef SKINNED
+layout(location=3) in ivec4 aBoneIds;
+layout(location=4) in vec4 aBoneWeights;
+
+// Skinning palettes streamed by BonePaletteBuffer, 4 RGBA32F texels per matrix
+uniform samplerBuffer boneMatrices;
+uniform int boneOffset; // index of this entity's first matrix
+
+mat4 fetchBone(int id) {
+    int base = (boneOffset + id) * 4;
+    return mat4(texelFetch(boneMatrices, base),
+                texelFetch(boneMatrices, base + 1),
+                texelFetch(boneMatrices, base + 2),
+                texelFetch(boneMatrices, base + 3));
+}
+#endif
+
+#ifdef INSTANCED
+// Per-instance model and normal matrices, streamed by the renderer (locations 5..8 and 9..11)
+layout(location=5) in mat4 aInstanceModel;
+layout(location=9) in mat3 aInstanceNormalMatrix;
+#else
+uniform mat4 model;
+uniform mat3 normalMatrix; // inverse transpose of model, computed on the CPU
+#endif
+
+// Written once per frame by Renderer::beginFrame (see UniformBlocks.hpp)
+layout(std140) uniform FrameData {
+    mat4 view;
+    mat4 proj;
+    vec4 viewPos;    // xyz
+    vec4 lightPos;   // xyz
+    vec4 lightColor; // rgb, a = intensity
+} frame;
+
 out VS_OUT{vec3 Pos;vec3 N;vec2 UV;} vs;
 
 void main(){
-    vec4 world = model*vec4(aPos,1);
+#ifdef INSTANCED
+    mat4 modelMatrix = aInstanceModel;
+    mat3 normalTransform = aInstanceNormalMatrix;
+#else
+    mat4 modelMatrix = model;
+    mat3 normalTransform = normalMatrix;
+#endif
+
+    vec4 position = vec4(aPos,1);
+    vec3 normal = aNormal;
+
+#ifdef SKINNED
+    mat4 boneTransform = mat4(0.0);
+    for (int i = 0; i < 4; i++) {
+        if (aBoneIds[i] >= 0) {
+            boneTransform += fetchBone(aBoneIds[i]) * aBoneWeights[i];
+        }
+    }
+
+    // Vertices without weights stay in bind pose
+    if (boneTransform == mat4(0.0)) {
+        boneTransform = mat4(1.0);
+    }
+
+    // Bones are assumed rigid (rotation and uniform scale), so the blended bone matrix
+    // transforms normals as is; the fragment shader renormalizes
+    position = boneTransform*position;
+    normal = mat3(boneTransform)*normal;
+#endif
+
+    vec4 world = modelMatrix*position;
     vs.Pos = world.xyz;
-    vs.N   = mat3(transpose(inverse(model)))*aNormal;
+    vs.N   = normalTransform*normal;
     vs.UV  = aUV;
-    gl_Position = proj*view*world;
+    gl_Position = frame.proj*frame.view*world;
 }
@@ -0,0 +1,47 @@
+#version 330 core
+
+// Pre-skinning pass: one point per vertex, rasterization discarded. The outputs are captured
+// with transform feedback into SkinningStage's buffer and drawn later by blinn.vert as static
+// geometry, so the bone blend runs once per frame instead of once per pass.
+
+layout(location=0) in vec3 aPos;
+layout(location=1) in vec3 aNormal;
+layout(location=2) in vec2 aUV;
+layout(location=3) in ivec4 aBoneIds;
+layout(location=4) in vec4 aBoneWeights;
+
+// Skinning palettes streamed by BonePaletteBuffer, 4 RGBA32F texels per matrix
+uniform samplerBuffer boneMatrices;
+uniform int boneOffset; // index of this entity's first matrix
+
+// Captured interleaved, matches SkinnedVertex in Vertex.hpp
+out vec3 skinnedPosition;
+out vec3 skinnedNormal;
+out vec2 skinnedUV;
+
+mat4 fetchBone(int id) {
+    int base = (boneOffset + id) * 4;
+    return mat4(texelFetch(boneMatrices, base),
+                texelFetch(boneMatrices, base + 1),
+                texelFetch(boneMatrices, base + 2),
+                texelFetch(boneMatrices, base + 3));
+}
+
+void main() {
+    // Only skinned meshes are queued, so every vertex is blended; unweighted vertices keep their bind pose
+    mat4 boneTransform = mat4(0.0);
+    for (int i = 0; i < 4; i++) {
+        if (aBoneIds[i] >= 0) {
+            boneTransform += fetchBone(aBoneIds[i]) * aBoneWeights[i];
+        }
+    }
+    if (boneTransform == mat4(0.0)) {
+        boneTransform = mat4(1.0);
+    }
+
+    // Model space; the model matrix is applied by the drawing pass
+    skinnedPosition = (boneTransform * vec4(aPos, 1.0)).xyz;
+    // Rigid bones (rotation and uniform scale) transform normals directly
+    skinnedNormal = mat3(boneTransform) * aNormal;
+    skinnedUV = aUV;
+}